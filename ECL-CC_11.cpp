@@ -41,34 +41,179 @@ June 2018.
 
 
 #include <algorithm>
+#include <climits>
+#include <cmath>
+#include <numeric>
 #include <stdlib.h>
 #include <stdio.h>
 #include <set>
+#include <type_traits>
 #include <vector>
 #include <random>
 #include <chrono>
+#include <string.h>
+#include <unistd.h>
 #include <sys/time.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 #include "ECLgraph.h"
+#include "ECLcgraph.h"
+#include "StoerWagner.h"
+#include "Kernel.h"
+#include "SimdCC.h"
+#include "Reorder.h"
 
-// check to see if edge exists in edgelist to be avoided
-static inline bool edgeverify(int v1, int v2, const std::vector< std::pair<int, int> >& edgelist) {
-  std::pair<int,int> edge = {std::min(v1, v2), std::max(v1, v2)};
+static inline int thread_id()
+{
+#ifdef _OPENMP
+  return omp_get_thread_num();
+#else
+  return 0;
+#endif
+}
 
-  return !( std::find(edgelist.begin(), edgelist.end(), edge) == edgelist.end() );
+static inline int thread_count()
+{
+#ifdef _OPENMP
+  return omp_get_max_threads();
+#else
+  return 1;
+#endif
 }
 
-void init(const int nodes, const int* const __restrict__ nidx, const int* const __restrict__ nlist, int* const __restrict__ nstat, const std::vector< std::pair<int, int> >& edgelist)
+// number of threads in the current team (1 when called from inside the parallel trial loop)
+static inline int team_size()
 {
-  #pragma omp parallel for schedule(guided) default(none) shared(nodes, nidx, nlist, nstat)
-  for (int v = 0; v < nodes; v++) {
-    const int beg = nidx[v];
-    const int end = nidx[v + 1];
-    int m = v;
-    int i = beg;
-    while ((m == v) && (i < end)) {
+#ifdef _OPENMP
+  return omp_get_num_threads();
+#else
+  return 1;
+#endif
+}
 
-      if (!edgeverify(m, nlist[i], edgelist)){
-        m =  nlist[i];
+// exclusive prefix sum in place; returns the total
+template <typename T>
+T prefix_sum(T* const a, const long long n)
+{
+  std::vector<T> part(thread_count() + 1, 0);
+  T total = 0;
+  #pragma omp parallel default(none) shared(a, n, part, total)
+  {
+    const int threads = team_size();
+    const int t = thread_id();
+    const long long beg = n * t / threads;
+    const long long end = n * (t + 1) / threads;
+    T sum = 0;
+    for (long long i = beg; i < end; i++) {
+      sum += a[i];
+    }
+    part[t + 1] = sum;
+    #pragma omp barrier
+    #pragma omp single
+    {
+      for (int k = 0; k < threads; k++) {
+        part[k + 1] += part[k];
+      }
+      total = part[threads];
+    }
+    T run = part[t];
+    for (long long i = beg; i < end; i++) {
+      const T val = a[i];
+      a[i] = run;
+      run += val;
+    }
+  }
+  return total;
+}
+
+// All kernels are templated on the vertex id type V and the edge offset type E so that the compact
+// 32-bit layout and the 64-bit edge-offset layout of ECLgraphT share one implementation.
+
+// an edge is kept in the current trial if its rank is at or above the threshold
+template <typename E>
+static inline bool edgekept(const E i, const E* const __restrict__ eid, const E* const __restrict__ rank, const E threshold)
+{
+  return rank[eid[i]] >= threshold;
+}
+
+// bits of +infinity: weight-0 edges get this key with random low bits, above every finite key, so that they are
+// contracted last and in random order (computing the key as 0 / 0 could give a NaN of either sign)
+#define ECL_INFINITE_KEY 0x7f800000U
+
+// 32-bit key from a 64-bit value (splitmix64 finalizer); with weights, the float bits of an exponential key with rate
+// 'weight', so that heavy edges tend to get small keys
+static inline unsigned mixkey(unsigned long long x, const int weight, const int weighted)
+{
+  x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+  x = x ^ (x >> 31);
+  const unsigned hash = (unsigned)(x >> 32);
+  if (!weighted) return hash;
+  if (weight <= 0) return ECL_INFINITE_KEY | (hash >> 9);
+
+  // exponential key with rate 'weight', as in create_weighted_permutation()
+  const float key = -std::log1p(-(hash * (1.0f / 4294967296.0f))) / weight;
+  unsigned bits;
+  memcpy(&bits, &key, sizeof(bits));
+  return bits;
+}
+
+// Keys computed on demand from the trial seed and the edge id instead of a permutation: with these, an edge is kept if
+// its key is below the threshold (small keys are contracted first), and no per-trial O(m) array is needed.
+struct EdgeHash {
+  unsigned long long seed;
+  const int* weights;  // NULL if the graph has no edge weights
+};
+
+template <typename E>
+static inline unsigned hashkey(const EdgeHash h, const E e)
+{
+  const unsigned long long x = h.seed + (unsigned long long)e * 0x9e3779b97f4a7c15ULL;
+  return (h.weights != NULL) ? mixkey(x, h.weights[e], 1) : mixkey(x, 1, 0);
+}
+
+template <typename E>
+static inline bool edgekept(const E i, const E* const __restrict__ eid, const EdgeHash h, const unsigned long long threshold)
+{
+  return hashkey(h, eid[i]) < threshold;
+}
+
+// vector unit used by init() and compute(), the widest one the CPU has unless -x asks for less
+static SimdLevel simd_level = SIMD_SCALAR;
+
+// the 32-bit layout with a rank array has vector versions of init() and compute() in SimdCC.h
+template <typename V, typename E, typename R, typename T>
+static constexpr bool has_simd()
+{
+  return std::is_same_v<V, int> && std::is_same_v<E, int> && std::is_convertible_v<R, const int*> && std::is_same_v<T, int>;
+}
+
+// The vector loops pay off when the rank test is hard to predict. When nearly every edge is kept, the scalar loops are
+// as fast or faster (init stops at the first slot, and compute's well-predicted branches let the CPU run ahead into the
+// next misses), so passes that keep more than 3/4 of the edges (ranks are 0 .. slots / 2 - 1) stay scalar.
+template <typename E>
+static inline bool simd_pays(const E slots, const E threshold)
+{
+  return 8 * (long long)threshold >= (long long)slots;
+}
+
+// the rank array (R = const E*) or an EdgeHash together with the matching threshold T selects the kept edges
+template <typename V, typename E, typename R, typename T>
+void init(const V nodes, const E* const __restrict__ nidx, const V* const __restrict__ nlist, V* const __restrict__ nstat, const E* const __restrict__ eid, const R rank, const T threshold)
+{
+  if constexpr (has_simd<V, E, R, T>()) {
+    if (simd_pays(nidx[nodes], threshold) && simd_init(simd_level, nodes, nidx, nlist, nstat, eid, rank, threshold)) return;
+  }
+  #pragma omp parallel for schedule(guided) default(none) shared(nodes, nidx, nlist, nstat, eid, rank, threshold)
+  for (V v = 0; v < nodes; v++) {
+    const E beg = nidx[v];
+    const E end = nidx[v + 1];
+    V m = v;
+    E i = beg;
+    while ((m == v) && (i < end)) {
+      if (edgekept(i, eid, rank, threshold)) {
+        m = std::min(m, nlist[i]);
       }
       i++;
     }
@@ -76,68 +221,62 @@ void init(const int nodes, const int* const __restrict__ nidx, const int* const
   }
 }
 
-static inline int representative(const int idx, int* const __restrict__ nstat)
+// hooks the tree whose root vstat tracks to the kept neighbors below 'below' in the slots beg to end - 1
+template <typename V, typename E, typename R, typename T>
+static inline void hook_range(V &vstat, const V below, const E beg, const E end, const V* const __restrict__ nlist, V* const __restrict__ nstat, const E* const __restrict__ eid, const R rank, const T threshold, CCcounters* const cnt)
 {
-  int curr = nstat[idx];
-  if (curr != idx) {
-    int next, prev = idx;
-    while (curr > (next = nstat[curr])) {
-      nstat[prev] = next;
-      prev = curr;
-      curr = next;
+  for (E i = beg; i < end; i++) {
+
+    const V nli = nlist[i];
+
+    // the cheap direction test first, so only one slot of every edge looks up (or hashes) its key
+    if (nli < below) {
+      if (edgekept(i, eid, rank, threshold)) {
+        hook(vstat, representative(nli, nstat, cnt), nstat, cnt);
+      }
+
     }
   }
-  return curr;
 }
 
-void compute(const int nodes, const int* const __restrict__ nidx, const int* const __restrict__ nlist, int* const __restrict__ nstat, const std::vector< std::pair<int, int> >& edgelist)
+// Vertices up to ECL_HUB_DEGREE slots are scanned whole by the thread that gets them from the guided schedule; the
+// lists of larger ones are split into tasks (hub_tasks in SimdCC.h), so one hub cannot hold up the pass.
+template <typename V, typename E, typename R, typename T>
+void compute(const V nodes, const E* const __restrict__ nidx, const V* const __restrict__ nlist, V* const __restrict__ nstat, const E* const __restrict__ eid, const R rank, const T threshold)
 {
-  #pragma omp parallel for schedule(guided) default(none) shared(nodes, nidx, nlist, nstat)
-  for (int v = 0; v < nodes; v++) {
-    const int vstat = nstat[v];
+  if constexpr (has_simd<V, E, R, T>()) {
+    if (simd_pays(nidx[nodes], threshold) && simd_compute(simd_level, nodes, nidx, nlist, nstat, eid, rank, threshold)) return;
+  }
+  CCcounters cnt = {}, hubs = {};
+  #pragma omp parallel for schedule(guided) default(none) shared(nodes, nidx, nlist, nstat, eid, rank, threshold, hubs) reduction(+: cnt)
+  for (V v = 0; v < nodes; v++) {
+    const V vstat = nstat[v];
     if (v  != vstat) {
-      const int beg = nidx[v];
-      const int end = nidx[v + 1];
-      int vstat = representative(v, nstat);
-      for (int i = beg; i < end; i++) {
-
-        const int nli = nlist[i];
-
-        if (!edgeverify(v, nli, edgelist)){
-          if (v > nli) {
-            int ostat = representative(nli, nstat);
-            bool repeat;
-            do {
-              repeat = false;
-              if (vstat != ostat) {
-                int ret;
-                if (vstat < ostat) {
-                  if ((ret = __sync_val_compare_and_swap(&nstat[ostat], ostat, vstat)) != ostat) {
-                    ostat = ret;
-                    repeat = true;
-                  }
-                } else {
-                  if ((ret = __sync_val_compare_and_swap(&nstat[vstat], vstat, ostat)) != vstat) {
-                    vstat = ret;
-                    repeat = true;
-                  }
-                }
-              }
-            } while (repeat);
-          }
-
-        }
+      const E beg = nidx[v];
+      const E end = nidx[v + 1];
+      if (end - beg > ECL_HUB_DEGREE) {
+        hub_tasks(beg, end, hubs, [=](const E b, const E e, CCcounters* const c) {
+          V vstat = representative(v, nstat, c);
+          hook_range(vstat, v, b, e, nlist, nstat, eid, rank, threshold, c);
+        });
+      } else {
+        V vstat = representative(v, nstat, &cnt);
+        hook_range(vstat, v, beg, end, nlist, nstat, eid, rank, threshold, &cnt);
       }
+      PROF_COUNT(cnt.slots += end - beg);
     }
   }
+  PROF_COUNT(prof_counters(cnt));
+  PROF_COUNT(prof_counters(hubs));
 }
 
-void flatten(const int nodes, int* const __restrict__ nstat)
+template <typename V>
+void flatten(const V nodes, V* const __restrict__ nstat)
 {
   #pragma omp parallel for default(none) shared(nodes, nstat)
-  for (int v = 0; v < nodes; v++) {
-    int next, vstat = nstat[v];
-    const int old = vstat;
+  for (V v = 0; v < nodes; v++) {
+    V next, vstat = nstat[v];
+    const V old = vstat;
     while (vstat > (next = nstat[vstat])) {
       vstat = next;
     }
@@ -145,117 +284,425 @@ void flatten(const int nodes, int* const __restrict__ nstat)
   }
 }
 
-static void verify(const int v, const int id, const int* const __restrict__ nidx, const int* const __restrict__ nlist, int* const __restrict__ nstat, const std::vector< std::pair<int, int> >& edgelist)
+// Afforest (Sutton, Ben-Nun, and Barak, 2018) as an alternative to init() and compute(): every vertex first links the
+// edges in its first few slots that are kept, which on low-diameter graphs already puts most vertices into one giant
+// component. The most frequent root among a sample of vertices names that component, and only the vertices outside it
+// then link the kept edges in their remaining slots. Every edge with an endpoint outside the giant component is
+// linked from that endpoint, and edges inside it cannot join anything, so the components are the same as with ECL-CC.
+// Selected with -a.
+enum CCAlgorithm {CC_ECL, CC_AFFOREST};
+
+static const char* const cc_names[] = {"ecl", "afforest"};
+
+static CCAlgorithm cc_algorithm = CC_ECL;
+
+// slots of every vertex that are linked before the giant component is picked, and the vertices sampled to pick it
+#define AFFOREST_ROUNDS 2
+#define AFFOREST_SAMPLES 1024
+
+// links every vertex with its neighbor in slot 'round' if that edge is kept
+template <typename V, typename E, typename R, typename T>
+static void afforest_link(const V nodes, const E* const __restrict__ nidx, const V* const __restrict__ nlist, V* const __restrict__ nstat, const E* const __restrict__ eid, const R rank, const T threshold, const int round)
+{
+  CCcounters cnt = {};
+  #pragma omp parallel for schedule(guided) default(none) shared(nodes, nidx, nlist, nstat, eid, rank, threshold, round) reduction(+: cnt)
+  for (V v = 0; v < nodes; v++) {
+    const E i = nidx[v] + round;
+    if ((i < nidx[v + 1]) && edgekept(i, eid, rank, threshold)) {
+      PROF_COUNT(cnt.slots++);
+      V vstat = representative(v, nstat, &cnt);
+      hook(vstat, representative(nlist[i], nstat, &cnt), nstat, &cnt);
+    }
+  }
+  PROF_COUNT(prof_counters(cnt));
+}
+
+// most frequent root among a fixed sample of the vertices of a flattened forest, or 'nodes' (no vertex) unless it holds
+// more than half of the sample
+template <typename V>
+static V afforest_giant(const V nodes, const V* const __restrict__ nstat)
 {
-  if (nstat[v] >= 0) {
-    if (nstat[v] != id) {fprintf(stderr, "ERROR: found incorrect ID value\n\n");  exit(-1);}
-    nstat[v] = -1;
-    for (int i = nidx[v]; i < nidx[v + 1]; i++) {
+  if (nodes == 0) return nodes;
+  std::vector<V> roots(AFFOREST_SAMPLES);
+  for (int k = 0; k < AFFOREST_SAMPLES; k++) {
+    roots[k] = nstat[(V)(((k + 1) * 0x9e3779b97f4a7c15ULL) % (unsigned long long)nodes)];
+  }
+  std::sort(roots.begin(), roots.end());
+  V giant = roots[0];
+  int best = 0;
+  for (int k = 0, run = 0; k < AFFOREST_SAMPLES; k++) {
+    run = ((k > 0) && (roots[k] == roots[k - 1])) ? run + 1 : 1;
+    if (run > best) {
+      best = run;
+      giant = roots[k];
+    }
+  }
+  return (2 * best > AFFOREST_SAMPLES) ? giant : nodes;
+}
 
-      if (!edgeverify(v, nlist[i], edgelist)){
-        verify(nlist[i], id, nidx, nlist, nstat, edgelist);
+// links the kept edges past the first AFFOREST_ROUNDS slots of every vertex outside the giant component, in both
+// directions. Without a giant component, all vertices are scanned, so every edge only needs linking from its larger
+// endpoint, and the direction test saves the key lookup of the other slot as in compute().
+template <typename V, typename E, typename R, typename T>
+static void afforest_finish(const V nodes, const E* const __restrict__ nidx, const V* const __restrict__ nlist, V* const __restrict__ nstat, const E* const __restrict__ eid, const R rank, const T threshold, const V giant)
+{
+  CCcounters cnt = {}, hubs = {};
+  #pragma omp parallel for schedule(guided) default(none) shared(nodes, nidx, nlist, nstat, eid, rank, threshold, giant, hubs) reduction(+: cnt)
+  for (V v = 0; v < nodes; v++) {
+    if (nstat[v] != giant) {
+      const E beg = nidx[v] + AFFOREST_ROUNDS;
+      const E end = nidx[v + 1];
+      const V below = (giant == nodes) ? v : nodes;
+      if (end - beg > ECL_HUB_DEGREE) {
+        hub_tasks(beg, end, hubs, [=](const E b, const E e, CCcounters* const c) {
+          V vstat = representative(v, nstat, c);
+          hook_range(vstat, below, b, e, nlist, nstat, eid, rank, threshold, c);
+        });
+      } else {
+        V vstat = representative(v, nstat, &cnt);
+        hook_range(vstat, below, beg, end, nlist, nstat, eid, rank, threshold, &cnt);
       }
+      PROF_COUNT(cnt.slots += std::max(end - beg, (E)0));
     }
   }
+  PROF_COUNT(prof_counters(cnt));
+  PROF_COUNT(prof_counters(hubs));
 }
 
+// leaves the same forest as init() and compute() (up to which root every component gets); the sampling rounds are
+// timed as init and the final pass as compute
+template <typename V, typename E, typename R, typename T>
+void afforest(const V nodes, const E* const __restrict__ nidx, const V* const __restrict__ nlist, V* const __restrict__ nstat, const E* const __restrict__ eid, const R rank, const T threshold)
+{
+  PROF_START(t0);
+  #pragma omp parallel for default(none) shared(nodes, nstat)
+  for (V v = 0; v < nodes; v++) {
+    nstat[v] = v;
+  }
+  for (int round = 0; round < AFFOREST_ROUNDS; round++) {
+    afforest_link(nodes, nidx, nlist, nstat, eid, rank, threshold, round);
+    flatten(nodes, nstat);
+  }
+  const V giant = afforest_giant(nodes, nstat);
+  PROF_PHASE(PH_INIT, t0);
+  PROF_START(t1);
+  afforest_finish(nodes, nidx, nlist, nstat, eid, rank, threshold, giant);
+  PROF_PHASE(PH_COMPUTE, t1);
+}
 
+// Breadth-first search over the kept edges that starts from all roots at once. Every edge it crosses must join equal
+// labels, and every vertex must be reached from the root its label names, which fails if two separate components
+// share an ID. The queue is explicit, so long paths cannot overflow the stack.
+template <typename V, typename E, typename R, typename T>
+static void verify(const V nodes, const E* const __restrict__ nidx, const V* const __restrict__ nlist, const V* const __restrict__ nstat, const E* const __restrict__ eid, const R rank, const T threshold)
+{
+  std::vector<unsigned char> seen(nodes, 0);
+  std::vector<V> queue(nodes);
+  V tail = 0;
+  #pragma omp parallel for default(none) shared(nodes, nstat, seen, queue, tail)
+  for (V v = 0; v < nodes; v++) {
+    if (nstat[v] == v) {
+      seen[v] = 1;
+      queue[__sync_fetch_and_add(&tail, (V)1)] = v;
+    }
+  }
 
-std::vector< std::pair<int, int> > edgelist_create(const int nodes, int * const __restrict__ nidx, int * const __restrict__ nlist) {
+  V head = 0;
+  while (head < tail) {
+    const V beg = head;
+    const V end = tail;
+    bool good = true;
+    #pragma omp parallel for schedule(guided) default(none) shared(beg, end, nidx, nlist, nstat, eid, rank, threshold, seen, queue, tail) reduction(&&: good)
+    for (V k = beg; k < end; k++) {
+      const V v = queue[k];
+      for (E i = nidx[v]; i < nidx[v + 1]; i++) {
+        if (edgekept(i, eid, rank, threshold)) {
+          const V u = nlist[i];
+          if (nstat[u] != nstat[v]) good = false;
+          if (__sync_bool_compare_and_swap(&seen[u], 0, 1)) {
+            queue[__sync_fetch_and_add(&tail, (V)1)] = u;
+          }
+        }
+      }
+    }
+    if (!good) {fprintf(stderr, "ERROR: found adjacent nodes in different components\n\n"); exit(-1);}
+    head = end;
+  }
+  if (tail != nodes) {fprintf(stderr, "ERROR: found incorrect ID value\n\n");  exit(-1);}
+}
 
-  std::set< std::pair<int,int> > edgelist_set;
-  for (int i = 0; i < nodes; i++) {
+// verify trial i when the sampling rate (fraction of trials, 0 to 1) steps past an integer, i.e., every 1/rate-th trial
+static inline bool sampled(const int i, const double rate)
+{
+  return std::floor((i + 1) * rate) > std::floor(i * rate);
+}
 
-    const int beg = nidx[i];
-    const int end = nidx[i + 1];
 
-    for (int j = beg; j < end; j++) {
 
-      int first = std::min(i, nlist[j]);
-      int second = std::max(i, nlist[j]);
-      std::pair<int,int> edge(first, second);
-        edgelist_set.insert(edge);
+// Build the deduplicated undirected edge list straight from CSR order: vertex v owns the first slot of every neighbor
+// u >= v, a prefix sum over the per-vertex counts places each vertex's edges, and eid maps every CSR slot (both
+// directions and duplicates) to its edge id. The result matches the sorted pair order for sorted neighbor lists.
+// Every edge has to be listed by both endpoints; a slot of the larger endpoint without its reverse is an error.
+template <typename V, typename E>
+static void edgelist_fill(const V nodes, const E* const __restrict__ nidx, const V* const __restrict__ nlist, std::vector< std::pair<V, V> >& edgelist, E* const __restrict__ eid)
+{
+  std::vector<E> offset(nodes + 1);
+  #pragma omp parallel for schedule(guided) default(none) shared(nodes, nidx, nlist, offset)
+  for (V v = 0; v < nodes; v++) {
+    E cnt = 0;
+    for (E i = nidx[v]; i < nidx[v + 1]; i++) {
+      if ((v <= nlist[i]) && ((i == nidx[v]) || (nlist[i] != nlist[i - 1]))) cnt++;
+    }
+    offset[v] = cnt;
+  }
+  offset[nodes] = 0;
+  const E num_edges = prefix_sum(offset.data(), (long long)nodes + 1);
+
+  edgelist.resize(num_edges);
+  #pragma omp parallel for schedule(guided) default(none) shared(nodes, nidx, nlist, offset, edgelist, eid)
+  for (V v = 0; v < nodes; v++) {
+    E pos = offset[v];
+    for (E i = nidx[v]; i < nidx[v + 1]; i++) {
+      if (v <= nlist[i]) {
+        if ((i == nidx[v]) || (nlist[i] != nlist[i - 1])) {
+          edgelist[pos] = std::pair<V, V>(v, nlist[i]);
+          eid[i] = pos++;
+        } else {
+          eid[i] = eid[i - 1];
+        }
+      }
     }
-
   }
 
-  std::vector< std::pair<int,int> > edgelist_vec(edgelist_set.begin(), edgelist_set.end());
-  return edgelist_vec;
+  // the other direction finds its edge in the (sorted) list of the smaller endpoint
+  bool symmetric = true;
+  #pragma omp parallel for schedule(guided) default(none) shared(nodes, nidx, nlist, eid) reduction(&&: symmetric)
+  for (V v = 0; v < nodes; v++) {
+    for (E i = nidx[v]; i < nidx[v + 1]; i++) {
+      const V u = nlist[i];
+      if (v > u) {
+        const V* const pos = std::lower_bound(nlist + nidx[u], nlist + nidx[u + 1], v);
+        if ((pos == nlist + nidx[u + 1]) || (*pos != v)) {
+          symmetric = false;
+        } else {
+          eid[i] = eid[pos - nlist];
+        }
+      }
+    }
+  }
+  if (!symmetric) {fprintf(stderr, "ERROR: graph is not symmetric (an edge is listed by only one endpoint)\n\n");  exit(-1);}
 }
 
-std::set<int> checkcc(const ECLgraph & g, int * nodestatus, const std::vector<std::pair<int, int>> & edgelist) {
+template <typename V, typename E>
+std::vector< std::pair<V, V> > edgelist_create(const V nodes, const E * const __restrict__ nidx, const V * const __restrict__ nlist, std::vector<E>& eid) {
 
-  init(g.nodes, g.nindex, g.nlist, nodestatus, edgelist);
-  compute(g.nodes, g.nindex, g.nlist, nodestatus, edgelist);
-  flatten(g.nodes, nodestatus);
+  std::vector< std::pair<V,V> > edgelist_vec;
+  eid.resize(nidx[nodes]);
 
-  std::set<int> s1;
-  for (int v = 0; v < g.nodes; v++) {
-    s1.insert(nodestatus[v]);
+  bool sorted = true;
+  #pragma omp parallel for default(none) shared(nodes, nidx, nlist) reduction(&&: sorted)
+  for (V v = 0; v < nodes; v++) {
+    for (E i = nidx[v] + 1; i < nidx[v + 1]; i++) {
+      if (nlist[i - 1] > nlist[i]) sorted = false;
+    }
+  }
+  if (sorted) {
+    edgelist_fill(nodes, nidx, nlist, edgelist_vec, eid.data());
+    return edgelist_vec;
   }
 
-  return s1;
+  // unsorted neighbor lists: build on a sorted copy and translate the slots back
+  std::vector<V> nlist_sorted(nidx[nodes]);
+  std::vector<E> slot(nidx[nodes]);
+  #pragma omp parallel for schedule(guided) default(none) shared(nodes, nidx, nlist, nlist_sorted, slot)
+  for (V v = 0; v < nodes; v++) {
+    std::iota(slot.begin() + nidx[v], slot.begin() + nidx[v + 1], nidx[v]);
+    std::sort(slot.begin() + nidx[v], slot.begin() + nidx[v + 1], [nlist](const E a, const E b) {return nlist[a] < nlist[b];});
+    for (E i = nidx[v]; i < nidx[v + 1]; i++) {
+      nlist_sorted[i] = nlist[slot[i]];
+    }
+  }
+  std::vector<E> eid_sorted(nidx[nodes]);
+  edgelist_fill(nodes, nidx, nlist_sorted.data(), edgelist_vec, eid_sorted.data());
+  #pragma omp parallel for default(none) shared(nidx, nodes, slot, eid, eid_sorted)
+  for (E i = 0; i < nidx[nodes]; i++) {
+    eid[slot[i]] = eid_sorted[i];
+  }
+  return edgelist_vec;
+}
 
-};
+// number of components after flatten(), i.e., the number of roots; counting stops early once more than 'limit' roots
+// have been seen, so the result is exact up to limit and only "more than limit" beyond that
+template <typename V>
+V components(const V nodes, const V* const __restrict__ nstat, const V limit = std::numeric_limits<V>::max())
+{
+  const V chunk = 1 << 14;
+  V count = 0;
+  #pragma omp parallel for schedule(dynamic) default(none) shared(nodes, nstat, limit, chunk, count)
+  for (V beg = 0; beg < nodes; beg += chunk) {
+    V seen;
+    #pragma omp atomic read
+    seen = count;
+    if (seen > limit) continue;
+    const V end = (nodes - beg > chunk) ? (V)(beg + chunk) : nodes;
+    V roots = 0;
+    for (V v = beg; v < end; v++) {
+      roots += (nstat[v] == v);
+    }
+    #pragma omp atomic
+    count += roots;
+  }
+  return count;
+}
 
-void runchecks(const ECLgraph & g, int * nodestatus, const std::vector<std::pair<int, int>> & edgelist, const std::set<int>& s1) {
-  for (int v = 0; v < g.nodes; v++) {
-    for (int i = g.nindex[v]; i < g.nindex[v + 1]; i++) {
+// dense component labels 0..k-1 in root order (label[v] is the label of v's component); returns k
+template <typename V>
+V component_labels(const V nodes, const V* const __restrict__ nstat, V* const __restrict__ label)
+{
+  #pragma omp parallel for default(none) shared(nodes, nstat, label)
+  for (V v = 0; v < nodes; v++) {
+    label[v] = (nstat[v] == v);
+  }
+  const V k = prefix_sum(label, nodes);
+  #pragma omp parallel for default(none) shared(nodes, nstat, label)
+  for (V v = 0; v < nodes; v++) {
+    if (nstat[v] != v) label[v] = label[nstat[v]];
+  }
+  return k;
+}
 
-      if (!edgeverify(v, g.nlist[i], edgelist)){
+template <typename V, typename E, typename R, typename T>
+V checkcc(const ECLgraphT<V, E> & g, V * nodestatus, const E * eid, const R rank, const T threshold, const V limit = std::numeric_limits<V>::max()) {
+
+  if (cc_algorithm == CC_AFFOREST) {
+    afforest(g.nodes, g.nindex, g.nlist, nodestatus, eid, rank, threshold);
+  } else {
+    PROF_START(t0);
+    init(g.nodes, g.nindex, g.nlist, nodestatus, eid, rank, threshold);
+    PROF_PHASE(PH_INIT, t0);
+    PROF_START(t1);
+    compute(g.nodes, g.nindex, g.nlist, nodestatus, eid, rank, threshold);
+    PROF_PHASE(PH_COMPUTE, t1);
+  }
+  PROF_START(t2);
+  flatten(g.nodes, nodestatus);
+  PROF_PHASE(PH_FLATTEN, t2);
+  PROF_START(t3);
+  const V ncomps = components(g.nodes, nodestatus, limit);
+  PROF_PHASE(PH_COMPONENTS, t3);
+  return ncomps;
+};
 
+// contract edges from the end of the permutation towards the front with union-find until 'target' components remain;
+// returns the threshold, i.e., the kept edges are exactly the ones that were walked
+template <typename V, typename E>
+E contract(const V nodes, const std::vector< std::pair<V, V> >& edgelist, const std::vector<E>& perm, V* const __restrict__ nstat, const V target = 2)
+{
+  for (V v = 0; v < nodes; v++) {
+    nstat[v] = v;
+  }
 
-        if (nodestatus[g.nlist[i]] != nodestatus[v]) {fprintf(stderr, "ERROR: found adjacent nodes in different components\n\n"); exit(-1);}
+  V merges = nodes - target;
+  E k = static_cast<E>( perm.size() );
+  while ((merges > 0) && (k > 0)) {
+    k--;
+    const V ra = representative(edgelist[perm[k]].first, nstat);
+    const V rb = representative(edgelist[perm[k]].second, nstat);
+    if (ra != rb) {
+      if (ra < rb) {
+        nstat[rb] = ra;
+      } else {
+        nstat[ra] = rb;
       }
-
+      merges--;
     }
   }
 
-  for (int v = 0; v < g.nodes; v++) {
-    if (nodestatus[v] < 0) {fprintf(stderr, "ERROR: found negative component number\n\n");  exit(-1);}
+  flatten(nodes, nstat);
+  return k;
+}
+
+// number of edges whose endpoints ended up in different components
+template <typename V>
+long long cutvalue(const std::vector< std::pair<V, V> >& edgelist, const V* const __restrict__ nstat)
+{
+  long long cut = 0;
+  for (const auto &[fst, snd] : edgelist) {
+    if (nstat[fst] != nstat[snd]) cut++;
+  }
+  return cut;
+}
+
+// total weight of the edges whose endpoints ended up in different components
+template <typename V>
+long long cutvalue(const std::vector< std::pair<V, V> >& edgelist, const std::vector<int>& weights, const V* const __restrict__ nstat)
+{
+  long long cut = 0;
+  for (std::size_t e = 0; e < edgelist.size(); e++) {
+    if (nstat[edgelist[e].first] != nstat[edgelist[e].second]) cut += weights[e];
   }
+  return cut;
+}
 
+// weight of every undirected edge, taken from the CSR slots
+template <typename V, typename E>
+std::vector<int> weights_create(const ECLgraphT<V, E> & g, const E* const __restrict__ eid, const E num_edges)
+{
+  std::vector<int> weights(num_edges);
+  for (E i = 0; i < g.edges; i++) {
+    if (g.eweight[i] < 0) {fprintf(stderr, "ERROR: found negative edge weight\n\n");  exit(-1);}
+    weights[eid[i]] = g.eweight[i];
+  }
+  return weights;
+}
 
-  std::set<int> s2;
-  int count = 0;
-  for (int v = 0; v < g.nodes; v++) {
-    if (nodestatus[v] >= 0) {
-      count++;
-      s2.insert(nodestatus[v]);
-      verify(v, nodestatus[v], g.nindex, g.nlist, nodestatus, edgelist);
+template <typename V, typename E, typename R, typename T>
+void runchecks(const ECLgraphT<V, E> & g, const V * nodestatus, const E * eid, const R rank, const T threshold, const V ncomps) {
+  PROF_START(t0);
+  const V nodes = g.nodes;
+  bool good = true;
+  V roots = 0;
+  #pragma omp parallel for default(none) shared(nodes, nodestatus) reduction(&&: good) reduction(+: roots)
+  for (V v = 0; v < nodes; v++) {
+    const V id = nodestatus[v];
+    if ((id < 0) || (id >= nodes)) {
+      good = false;
+    } else {
+      roots += (id == v);
     }
   }
-  if (s1.size() != s2.size()) {fprintf(stderr, "ERROR: number of components do not match\n\n");  exit(-1);}
-  if (s1.size() != (unsigned)count) {fprintf(stderr, "ERROR: component IDs are not unique\n\n");  exit(-1);}
+  if (!good) {fprintf(stderr, "ERROR: found negative component number\n\n");  exit(-1);}
+  if (roots != ncomps) {fprintf(stderr, "ERROR: number of components do not match\n\n");  exit(-1);}
+
+  verify(nodes, g.nindex, g.nlist, nodestatus, eid, rank, threshold);
+  PROF_PHASE(PH_VERIFY, t0);
 
   printf("all good\n\n");
 }
 
-void display_edges(const std::vector< std::pair<int, int> >& edgelist) {
+template <typename V>
+void display_edges(const std::vector< std::pair<V, V> >& edgelist) {
   for (const auto &[fst, snd] : edgelist) {
-    printf("(%d %d) ", fst, snd);
+    printf("(%lld %lld) ", (long long)fst, (long long)snd);
   }
   printf("\n");
 }
 
-void print_graph(const ECLgraph & g, const std::vector< std::pair<int, int> >& edgelist_cut) {
-  printf("%d nodes and %d edges\n", g.nodes, g.edges);
+template <typename V, typename E>
+void print_graph(const ECLgraphT<V, E> & g, const E * eid, const E * rank, const E threshold) {
+  printf("%lld nodes and %lld edges\n", (long long)g.nodes, (long long)g.edges);
 
-  ECLgraph g_cut{};
+  std::vector<E> nindex_cut;
+  std::vector<V> nlist_cut;
 
-  g_cut.nodes = g.nodes;
-
-  std::vector<int> nindex_cut;
-  std::vector<int> nlist_cut;
-
-  for (int v = 0; v <= g.nodes; v++) {
+  for (V v = 0; v <= g.nodes; v++) {
 
     // length as starting index
     nindex_cut.push_back(nlist_cut.size());
 
-    for (int i = g.nindex[v]; i < g.nindex[v + 1]; i++) {
+    for (E i = g.nindex[v]; i < g.nindex[v + 1]; i++) {
 
-      if (!edgeverify(v, g.nlist[i], edgelist_cut)){
+      if (edgekept(i, eid, rank, threshold)) {
         nlist_cut.push_back(g.nlist[i]);
       }
 
@@ -263,115 +710,1632 @@ void print_graph(const ECLgraph & g, const std::vector< std::pair<int, int> >& e
 
   }
 
-  // for (int v = 0; v < g_cut.nodes; v++) {
+  // for (V v = 0; v < g.nodes; v++) {
   //   printf("%d neighbors: ", v);
-  //   for (int i = nindex_cut[v]; i < nindex_cut[v + 1]; i++) {
+  //   for (E i = nindex_cut[v]; i < nindex_cut[v + 1]; i++) {
   //     printf("%d ", nlist_cut[i]);
   //   }
   //   printf("\n");
   // }
 }
 
-void create_permutation(std::vector< std::pair<int,int> > &edgelist) {
+// Philox4x32-10 (Salmon et al., 2011): four random words from a 128-bit counter and a 64-bit key, with no state in
+// between, so any key of any trial can be computed on its own, in any order, and replayed from the seeds alone
+static inline void philox(unsigned (&c)[4], const unsigned long long key)
+{
+  unsigned k0 = (unsigned)key;
+  unsigned k1 = (unsigned)(key >> 32);
+  for (int r = 0; r < 10; r++) {
+    const unsigned long long p0 = 0xD2511F53ULL * c[0];
+    const unsigned long long p1 = 0xCD9E8D57ULL * c[2];
+    const unsigned c0 = (unsigned)(p1 >> 32) ^ c[1] ^ k0;
+    const unsigned c2 = (unsigned)(p0 >> 32) ^ c[3] ^ k1;
+    c[1] = (unsigned)p1;
+    c[3] = (unsigned)p0;
+    c[0] = c0;
+    c[2] = c2;
+    k0 += 0x9E3779B9U;
+    k1 += 0xBB67AE85U;
+  }
+}
 
-  // generate random seed each time
-std::random_device rd;
-  // set random number engine
-  std::mt19937 engine(rd());
+// seed of a trial (and of its retries) under the master seed
+static inline unsigned long long trial_seed(const unsigned long long master, const unsigned long long trial, const unsigned attempt = 0)
+{
+  unsigned c[4] = {(unsigned)trial, (unsigned)(trial >> 32), attempt, 0};
+  philox(c, master);
+  return ((unsigned long long)c[1] << 32) | c[0];
+}
 
-  // set min max of random range
-  std::uniform_int_distribution<int> dist(0, static_cast<int>(edgelist.size()) - 1);
+// uniform 32-bit key of every edge for the trial seed: counter (e / 4, 0, 0, 0) gives the keys of edges e..e+3
+template <typename E>
+static void edge_keys(const unsigned long long seed, std::vector<unsigned>& keys, const E num_edges)
+{
+  keys.resize(((std::size_t)num_edges + 3) & ~(std::size_t)3);
+  unsigned* const __restrict__ k = keys.data();
+  const E blocks = (E)(keys.size() / 4);
+  #pragma omp simd
+  for (E b = 0; b < blocks; b++) {
+    unsigned c[4] = {(unsigned)b, (unsigned)((unsigned long long)b >> 32), 0, 0};
+    philox(c, seed);
+    k[4 * b + 0] = c[0];
+    k[4 * b + 1] = c[1];
+    k[4 * b + 2] = c[2];
+    k[4 * b + 3] = c[3];
+  }
+  keys.resize(num_edges);
+}
 
-  for (std::size_t i = 0; i < edgelist.size(); i++)
-  {
-    std::swap(edgelist[i], edgelist[dist(engine)]);
+// Fisher-Yates shuffle of the identity; step i takes the Philox key i of the seed and maps it to [0, i] with Lemire's
+// multiply-shift method, whose rare rejections (and steps of 2^32 and beyond) draw from the counters
+// (i, i >> 32, attempt, 1)
+template <typename E>
+static void shuffle_edges(const unsigned long long seed, std::vector<E> &perm, const std::vector<unsigned>& keys)
+{
+  const unsigned long long n = perm.size();
+  std::iota(perm.begin(), perm.end(), (E)0);
+  for (unsigned long long i = n - 1; (n > 1) && (i > 0); i--) {
+    const unsigned long long range = i + 1;
+    unsigned long long j;
+    if (range < (1ULL << 32)) {
+      unsigned long long m = (unsigned long long)keys[i] * range;
+      if ((unsigned)m < range) {
+        const unsigned t = (unsigned)(-(unsigned)range) % (unsigned)range;
+        for (unsigned attempt = 0; (unsigned)m < t; attempt++) {
+          unsigned c[4] = {(unsigned)i, (unsigned)(i >> 32), attempt, 1};
+          philox(c, seed);
+          m = (unsigned long long)c[0] * range;
+        }
+      }
+      j = m >> 32;
+    } else {
+      unsigned __int128 m;
+      unsigned attempt = 0;
+      do {
+        unsigned c[4] = {(unsigned)i, (unsigned)(i >> 32), attempt++, 1};
+        philox(c, seed);
+        m = (unsigned __int128)(((unsigned long long)c[1] << 32) | c[0]) * range;
+      } while ((unsigned long long)m < (0 - range) % range);
+      j = (unsigned long long)(m >> 64);
+    }
+    std::swap(perm[i], perm[j]);
   }
 }
 
-int main(int argc, char* argv[])
+// exponential key with rate w from a uniform 32-bit value; non-negative floats order like their bits, which are
+// inverted so that the smallest exponential keys come last
+template <typename W>
+static inline unsigned exponential_key(const unsigned uniform, const W w)
 {
-  printf("ECL-CC v1.1 OpenMP (%s)\n", __FILE__);
-  printf("Copyright 2017-2020 Texas State University\n");
+  if (w <= 0) return ~(ECL_INFINITE_KEY | (uniform >> 9));
+  const float key = -std::log1p(-((uniform >> 8) * (1.0f / 16777216.0f))) / w;
+  unsigned bits;
+  memcpy(&bits, &key, sizeof(bits));
+  return ~bits;
+}
+
+// perm lists the edges in ascending key order (LSD radix sort with 8-bit digits, stable, so ties keep edge order)
+template <typename E>
+static void radix_order(std::vector<E> &perm, const std::vector<unsigned>& keys, std::vector<E>& tmp)
+{
+  const E num_edges = static_cast<E>( keys.size() );
+  std::iota(perm.begin(), perm.end(), (E)0);
+  if (num_edges < 256) {
+    // the four passes would mostly clear and scan the counters; a comparison sort gives the same order
+    std::sort(perm.begin(), perm.end(), [&](const E a, const E b) { return (keys[a] < keys[b]) || ((keys[a] == keys[b]) && (a < b)); });
+    return;
+  }
+  tmp.resize(num_edges);
+  for (int shift = 0; shift < 32; shift += 8) {
+    E count[257] = {0};
+    for (E i = 0; i < num_edges; i++) {
+      count[((keys[perm[i]] >> shift) & 255) + 1]++;
+    }
+    for (int d = 0; d < 256; d++) {
+      count[d + 1] += count[d];
+    }
+    for (E i = 0; i < num_edges; i++) {
+      tmp[count[(keys[perm[i]] >> shift) & 255]++] = perm[i];
+    }
+    perm.swap(tmp);
+  }
+}
+
+// order edges for contract() so that an edge of weight w comes up as if it were w parallel unit edges: each edge gets an
+// exponential key with rate w and the smallest keys are contracted first (i.e., sit at the end of the permutation);
+// the keys are ordered with a radix sort on their float bits, which keeps this O(m)
+template <typename E, typename W>
+void create_weighted_permutation(std::vector<E> &perm, const std::vector<W>& weights, std::vector<unsigned>& keys, std::vector<E>& tmp, std::mt19937 &engine)
+{
+  const E num_edges = static_cast<E>( weights.size() );
+  keys.resize(num_edges);
+  for (E e = 0; e < num_edges; e++) {
+    keys[e] = exponential_key((unsigned)engine(), weights[e]);
+  }
+  radix_order(perm, keys, tmp);
+}
+
+// CSR graph used by the Karger-Stein recursion; parallel edges are merged into multiplicities and self-loops are dropped
+template <typename V, typename E>
+struct CSRgraph {
+  V nodes;
+  std::vector<E> nindex;
+  std::vector<V> nlist;
+  std::vector<long long> eweight;
+};
+
+template <typename V, typename E>
+CSRgraph<V, E> csr_create(const ECLgraphT<V, E> & g)
+{
+  CSRgraph<V, E> h;
+  h.nodes = g.nodes;
+  h.nindex.assign(g.nindex, g.nindex + g.nodes + 1);
+  h.nlist.assign(g.nlist, g.nlist + g.edges);
+  if (g.eweight != NULL) {
+    h.eweight.assign(g.eweight, g.eweight + g.edges);
+  } else {
+    h.eweight.assign(g.edges, 1);
+  }
+  return h;
+}
+
+// one entry per undirected edge (the v < u slot) together with its multiplicity
+template <typename V, typename E>
+static void csr_edges(const CSRgraph<V, E> & g, std::vector< std::pair<V, V> >& edges, std::vector<long long>& weights)
+{
+  edges.clear();
+  weights.clear();
+  for (V v = 0; v < g.nodes; v++) {
+    for (E i = g.nindex[v]; i < g.nindex[v + 1]; i++) {
+      if (v < g.nlist[i]) {
+        edges.emplace_back(v, g.nlist[i]);
+        weights.push_back(g.eweight[i]);
+      }
+    }
+  }
+}
+
+// build the CSR of the contracted graph from flattened component ids, relabeling the roots to 0..k-1
+template <typename V, typename E>
+static CSRgraph<V, E> csr_compact(const V nodes, const std::vector< std::pair<V, V> >& edges, const std::vector<long long>& weights, const V* const __restrict__ nstat)
+{
+  std::vector<V> label(nodes);
+  const V k = component_labels(nodes, nstat, label.data());
+
+  // bucket the surviving edges by endpoint
+  std::vector<E> nindex(k + 1, 0);
+  for (const auto &[fst, snd] : edges) {
+    const V a = label[fst];
+    const V b = label[snd];
+    if (a != b) {
+      nindex[a + 1]++;
+      nindex[b + 1]++;
+    }
+  }
+  for (V v = 0; v < k; v++) {
+    nindex[v + 1] += nindex[v];
+  }
+  std::vector<V> nlist(nindex[k]);
+  std::vector<long long> eweight(nindex[k]);
+  std::vector<E> pos(nindex.begin(), nindex.end() - 1);
+  for (std::size_t e = 0; e < edges.size(); e++) {
+    const V a = label[edges[e].first];
+    const V b = label[edges[e].second];
+    if (a != b) {
+      nlist[pos[a]] = b;
+      eweight[pos[a]++] = weights[e];
+      nlist[pos[b]] = a;
+      eweight[pos[b]++] = weights[e];
+    }
+  }
+
+  // merge parallel edges so no level holds more than O(k^2) entries
+  CSRgraph<V, E> h;
+  h.nodes = k;
+  h.nindex.resize(k + 1);
+  h.nlist.reserve(nlist.size());
+  h.eweight.reserve(nlist.size());
+  std::vector<E> slot(k, -1);
+  h.nindex[0] = 0;
+  for (V v = 0; v < k; v++) {
+    for (E i = nindex[v]; i < nindex[v + 1]; i++) {
+      const V u = nlist[i];
+      if ((slot[u] >= h.nindex[v]) && (h.nlist[slot[u]] == u)) {
+        h.eweight[slot[u]] += eweight[i];
+      } else {
+        slot[u] = static_cast<E>( h.nlist.size() );
+        h.nlist.push_back(u);
+        h.eweight.push_back(eweight[i]);
+      }
+    }
+    h.nindex[v + 1] = static_cast<E>( h.nlist.size() );
+  }
+  return h;
+}
+
+// graphs with up to this many vertices end the Karger-Stein recursion with an exact cut; contraction only removes
+// about one vertex per level near the bottom, so stopping earlier would leave a deep and bushy tail of tiny graphs
+#define ECL_KS_BASE 32
+
+// exact minimum cut of a small graph by Stoer-Wagner on an adjacency matrix (O(n^3), weights stay 64-bit)
+template <typename V, typename E>
+static long long small_cut(const CSRgraph<V, E> & g, std::vector<char>* const side)
+{
+  const V n = g.nodes;
+  std::vector<long long> w((std::size_t)n * n, 0);
+  for (V v = 0; v < n; v++) {
+    for (E i = g.nindex[v]; i < g.nindex[v + 1]; i++) {
+      w[(std::size_t)v * n + g.nlist[i]] += g.eweight[i];
+    }
+  }
+  // super vertex of every vertex, the vertices still in play, and the best phase
+  std::vector<V> merged(n), alive(n);
+  std::iota(merged.begin(), merged.end(), (V)0);
+  std::iota(alive.begin(), alive.end(), (V)0);
+  std::vector<long long> conn(n);
+  std::vector<char> added(n);
+  long long best = LLONG_MAX;
+  V best_t = 0;
+  std::vector<V> best_merged;
+  for (V k = n; k > 1; k--) {
+    std::fill(conn.begin(), conn.end(), 0);
+    std::fill(added.begin(), added.end(), 0);
+    V s = -1, t = -1;
+    for (V step = 0; step < k; step++) {
+      V x = -1;
+      for (V i = 0; i < k; i++) {
+        const V a = alive[i];
+        if (!added[a] && ((x < 0) || (conn[a] > conn[x]))) x = a;
+      }
+      added[x] = 1;
+      s = t;
+      t = x;
+      for (V i = 0; i < k; i++) {
+        const V a = alive[i];
+        if (!added[a]) conn[a] += w[(std::size_t)x * n + a];
+      }
+    }
+    if (conn[t] < best) {
+      best = conn[t];
+      best_t = t;
+      if (side != NULL) best_merged = merged;
+    }
+    // merge t into s
+    for (V i = 0; i < k; i++) {
+      const V a = alive[i];
+      w[(std::size_t)s * n + a] += w[(std::size_t)t * n + a];
+      w[(std::size_t)a * n + s] = w[(std::size_t)s * n + a];
+    }
+    w[(std::size_t)s * n + s] = 0;
+    for (V v = 0; v < n; v++) {
+      if (merged[v] == t) merged[v] = s;
+    }
+    alive.erase(std::find(alive.begin(), alive.begin() + k, t));
+  }
+  if (side != NULL) {
+    side->resize(n);
+    for (V v = 0; v < n; v++) {
+      (*side)[v] = (n > 1) && (best_merged[v] == best_t);
+    }
+  }
+  return (n > 1) ? best : 0;
+}
+
+// Karger-Stein: contract to about n/sqrt(2) vertices twice independently and recurse on both compacted graphs;
+// if side is given, it receives the side of every vertex for the best cut (this does not change the random stream)
+template <typename V, typename E>
+long long karger_stein(const CSRgraph<V, E> & g, std::mt19937 &engine, std::vector<char>* const side = NULL)
+{
+  if (g.nodes <= ECL_KS_BASE) return small_cut(g, side);
+
+  const V target = static_cast<V>( std::ceil(1.0 + g.nodes / std::sqrt(2.0)) );
+  std::vector< std::pair<V, V> > edges;
+  std::vector<long long> weights;
+  csr_edges(g, edges, weights);
+  std::vector<E> perm(edges.size());
+  std::vector<unsigned> keys;
+  std::vector<E> tmp;
+  std::vector<V> nstat(g.nodes);
+
+  long long best = LLONG_MAX;
+  std::vector<char> sub;
+  std::vector<V> label;
+  for (int branch = 0; branch < 2; branch++) {
+    create_weighted_permutation(perm, weights, keys, tmp, engine);
+    contract(g.nodes, edges, perm, nstat.data(), target);
+    const CSRgraph<V, E> h = csr_compact<V, E>(g.nodes, edges, weights, nstat.data());
+    const long long cut = karger_stein(h, engine, (side != NULL) ? &sub : NULL);
+    if (cut < best) {
+      best = cut;
+      if (side != NULL) {
+        label.resize(g.nodes);
+        component_labels(g.nodes, nstat.data(), label.data());
+        side->resize(g.nodes);
+        for (V v = 0; v < g.nodes; v++) {
+          (*side)[v] = sub[label[v]];
+        }
+      }
+    }
+  }
+  return best;
+}
+
+// Kernels for compressed graphs (ECLcgraph.h). They decode the neighbor lists while they scan and never materialize an
+// edge list or per-slot edge ids: the key of an edge is a hash of its endpoints and the trial seed, so both directions of
+// an edge agree, and an edge is kept if its key is below the threshold (small keys are contracted first).
+
+template <typename V>
+static inline unsigned edgekey(const V u, const V v, const int weight, const int weighted, const unsigned long long seed)
+{
+  return mixkey(seed + (unsigned long long)std::min(u, v) * 0x9e3779b97f4a7c15ULL + (unsigned long long)std::max(u, v), weight, weighted);
+}
+
+template <typename V, typename E>
+void init(const ECLcgraphT<V, E> & c, V* const __restrict__ nstat, const unsigned long long seed, const unsigned long long threshold)
+{
+  #pragma omp parallel for schedule(guided) default(none) shared(c, nstat, seed, threshold)
+  for (V v = 0; v < c.nodes; v++) {
+    ECLcdecoder<V> d(c.bytes, c.boff[v], v, c.weighted);
+    V m = v;
+    while ((m == v) && d.next()) {
+      if (edgekey(v, d.nbr, d.weight, c.weighted, seed) < threshold) {
+        m = std::min(m, d.nbr);
+      }
+    }
+    nstat[v] = m;
+  }
+}
+
+template <typename V, typename E>
+void compute(const ECLcgraphT<V, E> & c, V* const __restrict__ nstat, const unsigned long long seed, const unsigned long long threshold)
+{
+  CCcounters cnt = {};
+  #pragma omp parallel for schedule(guided) default(none) shared(c, nstat, seed, threshold) reduction(+: cnt)
+  for (V v = 0; v < c.nodes; v++) {
+    const V vstat = nstat[v];
+    if (v != vstat) {
+      V vstat = representative(v, nstat, &cnt);
+      ECLcdecoder<V> d(c.bytes, c.boff[v], v, c.weighted);
+      while (d.next()) {
+        const V nli = d.nbr;
+        PROF_COUNT(cnt.slots++);
+        if ((v > nli) && (edgekey(v, nli, d.weight, c.weighted, seed) < threshold)) {
+          hook(vstat, representative(nli, nstat, &cnt), nstat, &cnt);
+        }
+      }
+    }
+  }
+  PROF_COUNT(prof_counters(cnt));
+}
+
+template <typename V, typename E>
+V checkcc(const ECLcgraphT<V, E> & c, V * nodestatus, const unsigned long long seed, const unsigned long long threshold, const V limit = std::numeric_limits<V>::max()) {
+
+  PROF_START(t0);
+  init(c, nodestatus, seed, threshold);
+  PROF_PHASE(PH_INIT, t0);
+  PROF_START(t1);
+  compute(c, nodestatus, seed, threshold);
+  PROF_PHASE(PH_COMPUTE, t1);
+  PROF_START(t2);
+  flatten(c.nodes, nodestatus);
+  PROF_PHASE(PH_FLATTEN, t2);
+  PROF_START(t3);
+  const V ncomps = components(c.nodes, nodestatus, limit);
+  PROF_PHASE(PH_COMPONENTS, t3);
+  return ncomps;
+}
+
+// (weighted) number of edges whose endpoints ended up in different components
+template <typename V, typename E>
+long long cutvalue(const ECLcgraphT<V, E> & c, const V* const __restrict__ nstat)
+{
+  long long cut = 0;
+  for (V v = 0; v < c.nodes; v++) {
+    ECLcdecoder<V> d(c.bytes, c.boff[v], v, c.weighted);
+    while (d.next()) {
+      if ((v < d.nbr) && (nstat[v] != nstat[d.nbr])) cut += d.weight;
+    }
+  }
+  return cut;
+}
 
-  if (argc != 3) {fprintf(stderr, "USAGE: %s input_file_name number_permutations\n\n", argv[0]);  exit(-1);}
+template <typename V, typename E>
+void runchecks(const ECLcgraphT<V, E> & c, const V * nodestatus, const unsigned long long seed, const unsigned long long threshold) {
+  PROF_START(t0);
+  bool good = true;
+  #pragma omp parallel for schedule(guided) default(none) shared(c, nodestatus, seed, threshold) reduction(&&: good)
+  for (V v = 0; v < c.nodes; v++) {
+    if (nodestatus[v] < 0) good = false;
+    ECLcdecoder<V> d(c.bytes, c.boff[v], v, c.weighted);
+    while (d.next()) {
+      if ((edgekey(v, d.nbr, d.weight, c.weighted, seed) < threshold) && (nodestatus[d.nbr] != nodestatus[v])) good = false;
+    }
+  }
+  if (!good) {fprintf(stderr, "ERROR: found adjacent nodes in different components\n\n"); exit(-1);}
+  PROF_PHASE(PH_VERIFY, t0);
+
+  printf("all good\n\n");
+}
+
+// binary-search the smallest key threshold that leaves at most two components; returns false if two keys tie
+// across the step from more than two components to one, in which case the caller retries with another seed
+template <typename V, typename E>
+bool threshold_trial(const ECLcgraphT<V, E> & c, V * nodestatus, const unsigned long long seed, unsigned long long &threshold)
+{
+  unsigned long long lo = 0;
+  unsigned long long hi = 1ULL << 32;
+  if (checkcc(c, nodestatus, seed, lo, (V)2) <= 2) {
+    hi = lo;
+  }
+  while (hi - lo > 1) {
+    const unsigned long long mid = lo + (hi - lo) / 2;
+    if (checkcc(c, nodestatus, seed, mid, (V)2) <= 2) {
+      hi = mid;
+    } else {
+      lo = mid;
+    }
+  }
+  threshold = hi;
+  return checkcc(c, nodestatus, seed, threshold, (V)2) == 2;
+}
+
+// Threshold search over hashed keys: a histogram of the top 16 key bits (one pass over the edges) lets the search skip
+// every bucket boundary that does not change the kept edges, and the keys of the one bucket left are then sorted and
+// searched exactly. Like the ranked search, it stops at the first probe with exactly two components, so a trial takes
+// at most about log2(m) CC passes but keeps no per-edge array. Returns false if two equal keys straddle the step to two
+// components (the caller retries with another seed).
+template <typename V, typename E>
+bool hashed_trial(const ECLgraphT<V, E> & g, V * nodestatus, const E * eid, const E num_edges, const EdgeHash h, std::vector<E> &hist, std::vector<unsigned> &bucket, unsigned long long &threshold)
+{
+  PROF_START(t0);
+  hist.assign((1 << 16) + 1, 0);
+  for (E e = 0; e < num_edges; e++) {
+    hist[(hashkey(h, e) >> 16) + 1]++;
+  }
+  for (int b = 0; b < (1 << 16); b++) {
+    hist[b + 1] += hist[b];
+  }
+  PROF_PHASE(PH_PERMUTATION, t0);
+
+  // hist[b] edges are kept at threshold b << 16; find the bucket in which the count drops to two components
+  threshold = 0;
+  V ncomps = checkcc(g, nodestatus, eid, h, threshold, (V)2);
+  if (ncomps <= 2) return ncomps == 2;
+  int lo = 0;
+  int hi = 1 << 16;
+  while (hi - lo > 1) {
+    const int mid = lo + (hi - lo) / 2;
+    if (hist[mid] == hist[lo]) {
+      lo = mid;
+    } else if (hist[mid] == hist[hi]) {
+      hi = mid;
+    } else {
+      threshold = (unsigned long long)mid << 16;
+      ncomps = checkcc(g, nodestatus, eid, h, threshold, (V)2);
+      if (ncomps == 2) return true;
+      if (ncomps < 2) {
+        hi = mid;
+      } else {
+        lo = mid;
+      }
+    }
+  }
+
+  // exact search over the keys of bucket lo: the answer is one past one of them
+  bucket.clear();
+  for (E e = 0; e < num_edges; e++) {
+    const unsigned key = hashkey(h, e);
+    if ((int)(key >> 16) == lo) bucket.push_back(key);
+  }
+  std::sort(bucket.begin(), bucket.end());
+  bucket.erase(std::unique(bucket.begin(), bucket.end()), bucket.end());
+  long long klo = -1;
+  long long khi = (long long)bucket.size() - 1;
+  while (khi - klo > 1) {
+    const long long mid = klo + (khi - klo) / 2;
+    threshold = (unsigned long long)bucket[mid] + 1;
+    ncomps = checkcc(g, nodestatus, eid, h, threshold, (V)2);
+    if (ncomps == 2) return true;
+    if (ncomps < 2) {
+      khi = mid;
+    } else {
+      klo = mid;
+    }
+  }
+  threshold = (unsigned long long)bucket[khi] + 1;
+  return checkcc(g, nodestatus, eid, h, threshold, (V)2) == 2;
+}
+
+// per-thread state for independent trials
+template <typename V, typename E>
+struct Workspace {
+  std::vector<E> perm;
+  std::vector<E> rank;
+  std::vector<unsigned> keys;
+  std::vector<E> tmp;
+  std::vector<V> nodestatus;
+  std::mt19937 trial;  // reseeded from the seed of every Karger-Stein trial
+  long long best_cut;
+  int best_trial;  // lowest-numbered trial with the best cut, so the result does not depend on the schedule
+  unsigned long long best_seed;  // the best trial so far is replayed from its seed and threshold at the end (if any ran)
+  unsigned long long best_threshold;
+  Profile prof;  // sum over the trials of this thread
+};
+
+// rank of an edge is its position in the permutation; edges ranked below the threshold are removed
+template <typename E>
+void create_ranks(const std::vector<E> &perm, E * const __restrict__ rank) {
+  for (std::size_t k = 0; k < perm.size(); k++) {
+    rank[perm[k]] = static_cast<E>(k);
+  }
+}
+
+// the Karger-Stein recursion draws from an engine seeded with the trial seed
+static inline void seed_trial(std::mt19937 &engine, const unsigned long long seed)
+{
+  std::seed_seq seq{(unsigned)seed, (unsigned)(seed >> 32)};
+  engine.seed(seq);
+}
+
+// edge order and ranks of the trial with the given seed: a Fisher-Yates shuffle driven by the Philox keys or, with
+// weights, the order of their exponential transforms
+template <typename V, typename E>
+static void trial_permutation(Workspace<V, E> &ws, const unsigned long long seed, const std::vector<int> &weights, const bool weighted)
+{
+  const E num_edges = static_cast<E>( ws.perm.size() );
+  edge_keys(seed, ws.keys, num_edges);
+  if (weighted) {
+    unsigned* const __restrict__ k = ws.keys.data();
+    const int* const __restrict__ w = weights.data();
+    #pragma omp simd
+    for (E e = 0; e < num_edges; e++) {
+      k[e] = exponential_key(k[e], w[e]);
+    }
+    radix_order(ws.perm, ws.keys, ws.tmp);
+  } else {
+    shuffle_edges(seed, ws.perm, ws.keys);
+  }
+  create_ranks(ws.perm, ws.rank.data());
+}
+
+// result of a run: the cut value and the side (0 or 1) of every input vertex, if known
+struct CutResult {
+  long long value;
+  std::vector<char> side;
+};
+
+// Text file with the cut of a run: a line "cut <value> nodes <n>", one line with the side (0 or 1) of every vertex,
+// and then one line "u v weight" per crossing edge. The value is recomputed from the crossing edges of the input.
+// The graph may be a reordering of the input (-P), in which case ids holds the input id of every vertex and the file
+// uses the input ids.
+static std::vector<char> input_side(const std::vector<char> &side, const std::vector<long long>* const ids)
+{
+  if (ids == NULL) return side;
+  std::vector<char> in(side.size());
+  for (std::size_t v = 0; v < side.size(); v++) {
+    in[(*ids)[v]] = side[v];
+  }
+  return in;
+}
+
+static FILE* open_cut(const char* const fname, const std::vector<char> &side, const long long value, const std::vector<long long>* const ids)
+{
+  FILE* const f = fopen(fname, "w");  if (f == NULL) {fprintf(stderr, "ERROR: could not open file %s\n\n", fname);  exit(-1);}
+  fprintf(f, "cut %lld nodes %lld\n", value, (long long)side.size());
+  for (const char s : input_side(side, ids)) {
+    fputs(s ? "1\n" : "0\n", f);
+  }
+  return f;
+}
+
+static inline void print_cut_edge(FILE* const f, long long u, long long v, const long long weight, const std::vector<long long>* const ids)
+{
+  if (ids != NULL) {
+    u = (*ids)[u];
+    v = (*ids)[v];
+  }
+  fprintf(f, "%lld %lld %lld\n", std::min(u, v), std::max(u, v), weight);
+}
+
+template <typename V, typename E>
+long long cut_value(const ECLgraphT<V, E> & g, const std::vector<char> &side)
+{
+  long long value = 0;
+  for (V v = 0; v < g.nodes; v++) {
+    for (E i = g.nindex[v]; i < g.nindex[v + 1]; i++) {
+      if ((v < g.nlist[i]) && (side[v] != side[g.nlist[i]])) value += (g.eweight != NULL) ? g.eweight[i] : 1;
+    }
+  }
+  return value;
+}
+
+template <typename V, typename E>
+void write_cut(const char* const fname, const ECLgraphT<V, E> & g, const std::vector<char> &side, const std::vector<long long>* const ids = NULL)
+{
+  FILE* const f = open_cut(fname, side, cut_value(g, side), ids);
+  for (V v = 0; v < g.nodes; v++) {
+    for (E i = g.nindex[v]; i < g.nindex[v + 1]; i++) {
+      if ((v < g.nlist[i]) && (side[v] != side[g.nlist[i]])) print_cut_edge(f, v, g.nlist[i], (g.eweight != NULL) ? g.eweight[i] : 1, ids);
+    }
+  }
+  fclose(f);
+}
 
-  ECLgraph g = readECLgraph(argv[1]);
-  const int num_permutations = std::stoi(argv[2]);
+template <typename V, typename E>
+void write_cut(const char* const fname, const ECLcgraphT<V, E> & c, const std::vector<char> &side, const std::vector<long long>* const ids = NULL)
+{
+  long long value = 0;
+  for (V v = 0; v < c.nodes; v++) {
+    ECLcdecoder<V> d(c.bytes, c.boff[v], v, c.weighted);
+    while (d.next()) {
+      if ((v < d.nbr) && (side[v] != side[d.nbr])) value += d.weight;
+    }
+  }
+  FILE* const f = open_cut(fname, side, value, ids);
+  for (V v = 0; v < c.nodes; v++) {
+    ECLcdecoder<V> d(c.bytes, c.boff[v], v, c.weighted);
+    while (d.next()) {
+      if ((v < d.nbr) && (side[v] != side[d.nbr])) print_cut_edge(f, v, d.nbr, d.weight, ids);
+    }
+  }
+  fclose(f);
+}
+
+enum Engine {KRUSKAL, BSEARCH, HASHED, KARGER_STEIN, STOER_WAGNER};
+
+static const char* const engine_names[] = {"kruskal", "bsearch", "hash", "ks", "sw"};
+
+struct Options {
+  Engine engine;
+  int maphints;
+  bool stream;
+  bool certificate;
+  bool kernel;
+  const char* kernel_file;
+  const char* cut_file;
+  const char* profile_file;
+  Order order;
+  const char* reorder_file;
+  const char* map_file;
+  unsigned long long seed;
+  double verify_rate;
+  const char* fname;
+  int num_permutations;
+};
 
-  int* const nodestatus = new int [g.nodes];
-  printf("input graph: %d nodes and %d edges (%s)\n", g.nodes, g.edges, argv[1]);
+// profile of one trial together with what it found
+struct TrialProfile {
+  unsigned long long seed;
+  long long cut;
+  double time;
+  Profile prof;
+};
+
+static void print_profile(FILE* const f, const Profile &p)
+{
+  fprintf(f, "\"cc_passes\": %lld, \"phases\": {", p.calls[PH_INIT]);
+  for (int ph = 0; ph < PH_PHASES; ph++) {
+    fprintf(f, "%s\"%s\": {\"s\": %.6f, \"calls\": %lld}", (ph > 0) ? ", " : "", phase_names[ph], p.time[ph], p.calls[ph]);
+  }
+  fprintf(f, "}, \"slots\": %lld, \"cas\": %lld, \"cas_retries\": %lld, \"path_hist\": [", p.cc.slots, p.cc.cas, p.cc.retries);
+  for (int b = 0; b < ECL_PATH_BINS; b++) {
+    fprintf(f, "%s%lld", (b > 0) ? ", " : "", p.cc.paths[b]);
+  }
+  fprintf(f, "]");
+}
+
+// JSON file with the profile of every trial, of the work outside the trials ("setup"), and their sum; times are in
+// seconds, and path_hist[b] counts the representative() calls in compute that took 2^(b-1) to 2^b - 1 hops
+static void write_profile(const char* const fname, const Options &opts, const long long nodes, const long long edges, const std::vector<TrialProfile> &trials, const Profile &setup)
+{
+  FILE* const f = fopen(fname, "w");  if (f == NULL) {fprintf(stderr, "ERROR: could not open file %s\n\n", fname);  exit(-1);}
+  fprintf(f, "{\"graph\": \"%s\", \"nodes\": %lld, \"edges\": %lld, \"engine\": \"%s\", \"threads\": %d, \"vector_unit\": \"%s\", \"cc\": \"%s\", \"master_seed\": %llu,\n", opts.fname, nodes, edges, engine_names[opts.engine], thread_count(), simd_name(simd_level), cc_names[cc_algorithm], opts.seed);
+  fprintf(f, " \"trials\": [");
+  Profile total = setup;
+  for (std::size_t i = 0; i < trials.size(); i++) {
+    const TrialProfile &t = trials[i];
+    fprintf(f, "%s\n  {\"trial\": %lld, \"seed\": %llu, \"cut\": %lld, \"s\": %.6f, ", (i > 0) ? "," : "", (long long)i, t.seed, t.cut, t.time);
+    print_profile(f, t.prof);
+    fprintf(f, "}");
+    total += t.prof;
+  }
+  fprintf(f, "\n ],\n \"setup\": {");
+  print_profile(f, setup);
+  fprintf(f, "},\n \"total\": {");
+  print_profile(f, total);
+  fprintf(f, "}\n}\n");
+  fclose(f);
+}
+
+// where the time of the CC passes went, with the node and edge rates of ECL-original
+static void report_profile(const Profile &p, const long long nodes, const long long edges)
+{
+  const double cc = p.time[PH_INIT] + p.time[PH_COMPUTE] + p.time[PH_FLATTEN] + p.time[PH_COMPONENTS];
+  printf("phase times:");
+  for (int ph = 0; ph < PH_PHASES; ph++) {
+    printf(" %s %.4f s%s", phase_names[ph], p.time[ph], (ph < PH_PHASES - 1) ? "," : "\n");
+  }
+  if (cc > 0.0) printf("cc passes: %lld (%.3f Mnodes/s, %.3f Medges/s)\n", p.calls[PH_INIT], 0.000001 * nodes * p.calls[PH_INIT] / cc, 0.000001 * edges * p.calls[PH_INIT] / cc);
+  printf("edge slots linked over: %lld (%.2f per pass)\n", p.cc.slots, (p.calls[PH_INIT] > 0) ? (double)p.cc.slots / p.calls[PH_INIT] / std::max(edges, 1LL) : 0.0);
+  printf("cas: %lld attempts, %lld retries\n", p.cc.cas, p.cc.retries);
+}
+
+// prints the cut value in the units of the input and returns the cut with the side of every input vertex, if known
+template <typename V, typename E>
+static CutResult report_cut(long long cut, const std::vector<char>* side, const Kernel<V, E>* const kernel, const bool weighted)
+{
+  std::vector<char> expanded;
+  if (kernel != NULL) {
+    if (kernel->bound <= cut) {
+      cut = kernel->bound;
+      side = &kernel->side;
+    } else if (side != NULL) {
+      expanded.resize(kernel->map.size());
+      for (std::size_t v = 0; v < kernel->map.size(); v++) {
+        expanded[v] = (*side)[kernel->map[v]];
+      }
+      side = &expanded;
+    }
+  }
+  if ((kernel != NULL) ? kernel->weighted : weighted) {
+    printf("minimum cut found: %lld total weight\n", cut);
+  } else {
+    printf("minimum cut found: %lld edges\n", cut);
+  }
+  return CutResult{cut, (side != NULL) ? *side : std::vector<char>()};
+}
+
+// with a kernel, g is the kernel and the results are reported for the graph it came from
+template <typename V, typename E>
+CutResult karger(const ECLgraphT<V, E> & g, const Options & opts, const Kernel<V, E>* const kernel = NULL)
+{
+  const Engine engine = opts.engine;
+  const int num_permutations = opts.num_permutations;
+  const double verify_rate = opts.verify_rate;
+
+  V* const nodestatus = new V [g.nodes];
+  printf("input graph: %lld nodes and %lld edges (%s)\n", (long long)g.nodes, (long long)g.edges, opts.fname);
+  printf("index widths: %d-bit vertex ids, %d-bit edge offsets\n", (int)sizeof(V) * 8, (int)sizeof(E) * 8);
   printf("average degree: %.2f edges per node\n", 1.0 * g.edges / g.nodes);
-  int mindeg = g.nodes;
-  int maxdeg = 0;
-  for (int v = 0; v < g.nodes; v++) {
-    int deg = g.nindex[v + 1] - g.nindex[v];
+  E mindeg = g.nodes;
+  E maxdeg = 0;
+  for (V v = 0; v < g.nodes; v++) {
+    E deg = g.nindex[v + 1] - g.nindex[v];
     mindeg = std::min(mindeg, deg);
     maxdeg = std::max(maxdeg, deg);
   }
-  printf("minimum degree: %d edges\n", mindeg);
-  printf("maximum degree: %d edges\n", maxdeg);
+  printf("minimum degree: %lld edges\n", (long long)mindeg);
+  printf("maximum degree: %lld edges\n", (long long)maxdeg);
+
+  // edge weights are capacities: contraction samples edges in proportion to weight and cuts sum the weights
+  const bool weighted = (g.eweight != NULL);
+  long long minwdeg = mindeg;
+  if (weighted) {
+    minwdeg = LLONG_MAX;
+    for (V v = 0; v < g.nodes; v++) {
+      long long wdeg = 0;
+      for (E i = g.nindex[v]; i < g.nindex[v + 1]; i++) {
+        wdeg += g.eweight[i];
+      }
+      minwdeg = std::min(minwdeg, wdeg);
+    }
+    printf("minimum weighted degree: %lld\n", minwdeg);
+  }
+
+  // the minimum (weighted) degree bounds the minimum cut, so a sparse certificate for that value keeps the answer
+  if (opts.certificate) {
+    struct timeval start, end;
+    gettimeofday(&start, NULL);
+    ECLgraphT<V, E> h = sparse_certificate(g, minwdeg);
+    gettimeofday(&end, NULL);
+    const double runtime = end.tv_sec + end.tv_usec / 1000000.0 - start.tv_sec - start.tv_usec / 1000000.0;
+    printf("sparse certificate: k = %lld, %lld of %lld edges kept (%.4f s)\n\n", minwdeg, (long long)h.edges, (long long)g.edges, runtime);
+    Options sparse = opts;
+    sparse.certificate = false;
+    delete [] nodestatus;
+    CutResult res = karger(h, sparse);
+    freeECLgraph(h);
+
+    // a cut of exactly k in the certificate can be heavier in g, but then the lightest vertex is a cut of value k
+    if (cut_value(g, res.side) > res.value) {
+      V light = 0;
+      long long lightest = LLONG_MAX;
+      for (V v = 0; v < g.nodes; v++) {
+        long long wdeg = 0;
+        for (E i = g.nindex[v]; i < g.nindex[v + 1]; i++) {
+          wdeg += weighted ? g.eweight[i] : 1;
+        }
+        if (wdeg < lightest) {
+          lightest = wdeg;
+          light = v;
+        }
+      }
+      res.side.assign(g.nodes, 0);
+      res.side[light] = 1;
+    }
+    return res;
+  }
+
+  // contract the edges the reductions rule out and run on what is left
+  if (opts.kernel) {
+    struct timeval start, end;
+    gettimeofday(&start, NULL);
+    Kernel<V, E> k = kernelize(g);
+    gettimeofday(&end, NULL);
+    const double runtime = end.tv_sec + end.tv_usec / 1000000.0 - start.tv_sec - start.tv_usec / 1000000.0;
+    printf("kernel: %lld nodes and %lld edges after %d rounds, cut bound %lld (%.4f s)\n\n", (long long)k.graph.nodes, (long long)k.graph.edges, k.rounds, k.bound, runtime);
+    if (opts.kernel_file != NULL) writeKernel(k, opts.kernel_file);
+    delete [] nodestatus;
+    CutResult res;
+    if (k.graph.nodes < 2) {
+      res = report_cut(LLONG_MAX, (const std::vector<char>*)NULL, &k, weighted);
+    } else {
+      Options reduced = opts;
+      reduced.kernel = false;
+      res = karger(k.graph, reduced, &k);
+    }
+    freeECLgraph(k.graph);
+    return res;
+  }
 
-  // get initial list of edges
-  std::vector< std::pair<int,int> > edgelist = edgelist_create(g.nodes, g.nindex, g.nlist);
+  // work outside the trials is profiled separately from the trials
+  Profile setup = {};
+  ProfileScope scope(&setup);
+
+  // get initial list of edges and give every CSR slot the id of its undirected edge so the kernels can mask edges by rank
+  std::vector<E> eid;
+  PROF_START(t0);
+  std::vector< std::pair<V,V> > edgelist = edgelist_create(g.nodes, g.nindex, g.nlist, eid);
+  PROF_PHASE(PH_EDGELIST, t0);
 
   if (edgelist.empty()) {fprintf(stderr, "ERROR: no edges found\n\n");  exit(-1);}
 
-  // do initial check to see how many connected components exist in the graph
-  std::set s1  = checkcc(g, nodestatus, std::vector< std::pair<int,int> >());
+  const E num_edges = static_cast<E>( edgelist.size() );
+  const std::vector<int> weights = weighted ? weights_create(g, eid.data(), num_edges) : std::vector<int>();
+
+  // do initial check to see how many connected components exist in the graph (threshold 0 keeps every edge)
+  std::vector<E> rank0(num_edges, 0);
+  const V ncomps = checkcc(g, nodestatus, eid.data(), rank0.data(), (E)0);
+
+  if (ncomps >= 2){fprintf(stderr, "ERROR: found 2 or more connected components in initial graph\n\n");  exit(-1);}
+
+  runchecks(g, nodestatus, eid.data(), rank0.data(), (E)0, ncomps);
+
+  // the exact engine runs once, whatever the number of permutations
+  if (engine == STOER_WAGNER) {
+    struct timeval start, end;
+    gettimeofday(&start, NULL);
+    std::vector<char> side;
+    const long long best_cut = stoer_wagner(g, &side);
+    gettimeofday(&end, NULL);
+    const double runtime = end.tv_sec + end.tv_usec / 1000000.0 - start.tv_sec - start.tv_usec / 1000000.0;
+    printf("trial time: %.4f s\n", runtime);
+    if (opts.profile_file != NULL) write_profile(opts.profile_file, opts, g.nodes, g.edges, std::vector<TrialProfile>(), setup);
+    delete [] nodestatus;
+    return report_cut(best_cut, &side, kernel, weighted);
+  }
+
+  // every thread gets its own status array and best-cut slot; trial i draws from the seed of i under the master seed
+  const unsigned long long master = opts.seed;
+  const int num_threads = thread_count();
+  std::vector< Workspace<V, E> > workspaces(num_threads);
+  for (int t = 0; t < num_threads; t++) {
+    Workspace<V, E>& ws = workspaces[t];
+    if (engine != HASHED) {
+      ws.perm.resize(num_edges);
+      ws.rank.resize(num_edges);
+    }
+    ws.nodestatus.resize(g.nodes);
+    ws.best_cut = LLONG_MAX;
+    ws.best_trial = INT_MAX;
+    ws.best_seed = 0;
+    ws.best_threshold = 0;
+    ws.prof = Profile{};
+  }
+  printf("trial threads: %d\n", num_threads);
+  if (verify_rate < 1.0) printf("verified trials: %.1f%%\n", verify_rate * 100.0);
+  std::vector<TrialProfile> trials((opts.profile_file != NULL) ? num_permutations : 0);
+
+  const CSRgraph<V, E> csr = (engine == KARGER_STEIN) ? csr_create(g) : CSRgraph<V, E>{};
+
+  struct timeval start, end;
+  gettimeofday(&start, NULL);
+
+  #pragma omp parallel for schedule(dynamic) default(none) shared(num_permutations, workspaces, g, edgelist, eid, weights, weighted, engine, num_edges, csr, verify_rate, master, trials)
+  for (int i = 0; i < num_permutations; i++)
+  {
+    Workspace<V, E>& ws = workspaces[thread_id()];
+    TrialProfile tp = {};
+    ProfileScope trial_scope(&tp.prof);
+    PROF_START(t0);
+
+    // seed the trial ended up using (hashed trials retry on ties) and the threshold it stopped at
+    unsigned long long seed = trial_seed(master, i);
+    unsigned long long threshold = 0;
+    long long cut;
+    V* const nodestatus = ws.nodestatus.data();
+
+    if (engine == KARGER_STEIN) {
+      seed_trial(ws.trial, seed);
+      cut = karger_stein(csr, ws.trial);
+    } else if (engine == HASHED) {
+      // retries with the next attempt seed if two keys tie at the threshold
+      unsigned attempt = 1;
+      while (!hashed_trial(g, nodestatus, eid.data(), num_edges, EdgeHash{seed, weighted ? weights.data() : NULL}, ws.tmp, ws.keys, threshold)) {
+        seed = trial_seed(master, i, attempt++);
+      }
+      cut = weighted ? cutvalue(edgelist, weights, nodestatus) : cutvalue(edgelist, nodestatus);
+      if (sampled(i, verify_rate)) runchecks(g, nodestatus, eid.data(), EdgeHash{seed, weighted ? weights.data() : NULL}, threshold, (V)2);
+    } else {
+      E* const rank = ws.rank.data();
+      PROF_START(t1);
+      trial_permutation(ws, seed, weights, weighted);
+      PROF_PHASE(PH_PERMUTATION, t1);
+
+      // the first 'threshold' edges of the permutation are removed, the rest are kept
+      E cut_threshold = num_edges;
+      E cut_size = num_edges;
+      V ncomps;
+
+      if (engine == KRUSKAL) {
+        PROF_START(t2);
+        cut_threshold = contract(g.nodes, edgelist, ws.perm, nodestatus);
+        PROF_PHASE(PH_COMPUTE, t2);
+        PROF_START(t3);
+        ncomps = components(g.nodes, nodestatus);
+        PROF_PHASE(PH_COMPONENTS, t3);
+      } else {
+        while (true) {
+          // only <2, ==2, or >2 matters here, so the root count can stop after the third root
+          ncomps = checkcc(g, nodestatus, eid.data(), rank, cut_threshold, (V)2);
+
+          if (ncomps == 2) {
+            break;
+          }
+          cut_size = cut_size / 2;
+          if (ncomps < 2) {
+            cut_threshold = cut_threshold + std::max(cut_size, (E)1);
+          }
+          else {
+            cut_threshold = cut_threshold - std::max(cut_size, (E)1);
+          }
+        }
+      }
+      threshold = cut_threshold;
+
+      cut = weighted ? cutvalue(edgelist, weights, nodestatus) : cutvalue(edgelist, nodestatus);
 
-  if ((int)s1.size() >=2){fprintf(stderr, "ERROR: found 2 or more connected components in initial graph\n\n");  exit(-1);}
+      if (sampled(i, verify_rate)) runchecks(g, nodestatus, eid.data(), rank, cut_threshold, ncomps);
+    }
 
-  runchecks(g, nodestatus, std::vector< std::pair<int,int> >(), s1);
+    if (ws.best_cut > cut) {
+      ws.best_cut = cut;
+      ws.best_trial = i;
+      ws.best_seed = seed;
+      ws.best_threshold = threshold;
+    }
+    PROF_COUNT(tp.time = prof_now() - t0);
+    ws.prof += tp.prof;
+    if (!trials.empty()) {
+      tp.seed = seed;
+      tp.cut = cut;
+      trials[i] = tp;
+    }
+  }
 
-  std::vector< std::pair<int,int> > best_edgelist = edgelist;
+  gettimeofday(&end, NULL);
+  double runtime = end.tv_sec + end.tv_usec / 1000000.0 - start.tv_sec - start.tv_usec / 1000000.0;
 
+  // reduce the per-thread results
+  int best = 0;
+  for (int t = 1; t < num_threads; t++) {
+    const Workspace<V, E>& a = workspaces[best];
+    const Workspace<V, E>& b = workspaces[t];
+    if ((a.best_cut > b.best_cut) || ((a.best_cut == b.best_cut) && (a.best_trial > b.best_trial))) best = t;
+  }
+  Workspace<V, E>& ws = workspaces[best];
+  const long long best_cut = ws.best_cut;
+
+  // replay the best trial for its partition (without trials, there is none)
+  const bool replay = (ws.best_trial != INT_MAX);
+  std::vector<char> side(replay ? g.nodes : 0);
+  if (replay) {
+    if (engine == KARGER_STEIN) {
+      seed_trial(ws.trial, ws.best_seed);
+      // from inside a parallel region like in the trial loop, so the many small parallel regions of the recursion stay serial
+      #pragma omp parallel default(none) shared(csr, ws, side)
+      #pragma omp single
+      karger_stein(csr, ws.trial, &side);
+    } else if (engine == HASHED) {
+      checkcc(g, nodestatus, eid.data(), EdgeHash{ws.best_seed, weighted ? weights.data() : NULL}, ws.best_threshold);
+      for (V v = 0; v < g.nodes; v++) {
+        side[v] = (nodestatus[v] != nodestatus[0]);
+      }
+    } else {
+      trial_permutation(ws, ws.best_seed, weights, weighted);
+      checkcc(g, nodestatus, eid.data(), ws.rank.data(), (E)ws.best_threshold);
+      for (V v = 0; v < g.nodes; v++) {
+        side[v] = (nodestatus[v] != nodestatus[0]);
+      }
+    }
+    long long replayed = 0;
+    for (E e = 0; e < num_edges; e++) {
+      if (side[edgelist[e].first] != side[edgelist[e].second]) replayed += weighted ? weights[e] : 1;
+    }
+    if (replayed != best_cut) {fprintf(stderr, "ERROR: replaying the best trial gave a cut of %lld instead of %lld\n\n", replayed, best_cut);  exit(-1);}
+  }
+
+  printf("trial time: %.4f s\n", runtime);
+  printf("throughput: %.3f trials/s\n", num_permutations / runtime);
+#if ECL_PROFILE
+  Profile total = setup;
+  for (int t = 0; t < num_threads; t++) total += workspaces[t].prof;
+  report_profile(total, g.nodes, g.edges);
+#endif
+  if (opts.profile_file != NULL) write_profile(opts.profile_file, opts, g.nodes, g.edges, trials, setup);
+
+  delete [] nodestatus;
+  return report_cut(best_cut, replay ? &side : NULL, kernel, weighted);
+}
+
+// trials on a compressed graph: every trial binary-searches a key threshold with CC passes that decode the graph,
+// so the memory footprint is the compressed graph plus one status array per thread
+template <typename V, typename E>
+CutResult karger(const ECLcgraphT<V, E> & c, const Options & opts)
+{
+  const int num_permutations = opts.num_permutations;
+  const double verify_rate = opts.verify_rate;
+
+  printf("input graph: %lld nodes and %lld edges (%s)\n", (long long)c.nodes, (long long)c.edges, opts.fname);
+  printf("compressed: %.2f bytes per edge\n", (double)c.boff[c.nodes] / std::max(c.edges, (E)1));
+  if (opts.engine != BSEARCH) printf("compressed graphs always use the threshold search engine\n");
+
+  Profile setup = {};
+  ProfileScope scope(&setup);
+  V* const nodestatus = new V [c.nodes];
+  if (checkcc(c, nodestatus, 0ULL, 1ULL << 32) >= 2) {fprintf(stderr, "ERROR: found 2 or more connected components in initial graph\n\n");  exit(-1);}
+  runchecks(c, nodestatus, 0ULL, 1ULL << 32);
+
+  const unsigned long long master = opts.seed;
+  const int num_threads = thread_count();
+  std::vector< Workspace<V, E> > workspaces(num_threads);
+  for (int t = 0; t < num_threads; t++) {
+    Workspace<V, E>& ws = workspaces[t];
+    ws.nodestatus.resize(c.nodes);
+    ws.best_cut = LLONG_MAX;
+    ws.best_trial = INT_MAX;
+    ws.best_seed = 0;
+    ws.best_threshold = 0;
+    ws.prof = Profile{};
+  }
+  printf("trial threads: %d\n", num_threads);
+  if (verify_rate < 1.0) printf("verified trials: %.1f%%\n", verify_rate * 100.0);
+  std::vector<TrialProfile> trials((opts.profile_file != NULL) ? num_permutations : 0);
+
+  struct timeval start, end;
+  gettimeofday(&start, NULL);
+
+  #pragma omp parallel for schedule(dynamic) default(none) shared(num_permutations, workspaces, c, verify_rate, master, trials)
   for (int i = 0; i < num_permutations; i++)
   {
+    Workspace<V, E>& ws = workspaces[thread_id()];
+    V* const nodestatus = ws.nodestatus.data();
+    TrialProfile tp = {};
+    ProfileScope trial_scope(&tp.prof);
+    PROF_START(t0);
+
+    unsigned long long seed, threshold;
+    unsigned attempt = 0;
+    do {
+      seed = trial_seed(master, i, attempt++);
+    } while (!threshold_trial(c, nodestatus, seed, threshold));
+
+    const long long cut = cutvalue(c, nodestatus);
+
+    if (sampled(i, verify_rate)) runchecks(c, nodestatus, seed, threshold);
+
+    if (ws.best_cut > cut) {
+      ws.best_cut = cut;
+      ws.best_trial = i;
+      ws.best_seed = seed;
+      ws.best_threshold = threshold;
+    }
+    PROF_COUNT(tp.time = prof_now() - t0);
+    ws.prof += tp.prof;
+    if (!trials.empty()) {
+      tp.seed = seed;
+      tp.cut = cut;
+      trials[i] = tp;
+    }
+  }
 
-    std::vector< std::pair<int,int> > edgelist_cut = edgelist;
+  gettimeofday(&end, NULL);
+  double runtime = end.tv_sec + end.tv_usec / 1000000.0 - start.tv_sec - start.tv_usec / 1000000.0;
 
-    create_permutation(edgelist_cut);
+  int best = 0;
+  for (int t = 1; t < num_threads; t++) {
+    const Workspace<V, E>& a = workspaces[best];
+    const Workspace<V, E>& b = workspaces[t];
+    if ((a.best_cut > b.best_cut) || ((a.best_cut == b.best_cut) && (a.best_trial > b.best_trial))) best = t;
+  }
+  const long long best_cut = workspaces[best].best_cut;
+
+  // replay the best trial for its partition (without trials, there is none)
+  std::vector<char> side;
+  if (workspaces[best].best_trial != INT_MAX) {
+    checkcc(c, nodestatus, workspaces[best].best_seed, workspaces[best].best_threshold);
+    side.resize(c.nodes);
+    for (V v = 0; v < c.nodes; v++) {
+      side[v] = (nodestatus[v] != nodestatus[0]);
+    }
+  }
 
-    int cut_size = static_cast<int>( edgelist_cut.size() );
+  printf("trial time: %.4f s\n", runtime);
+  printf("throughput: %.3f trials/s\n", num_permutations / runtime);
+#if ECL_PROFILE
+  Profile total = setup;
+  for (int t = 0; t < num_threads; t++) total += workspaces[t].prof;
+  report_profile(total, c.nodes, c.edges);
+#endif
+  if (opts.profile_file != NULL) write_profile(opts.profile_file, opts, c.nodes, c.edges, trials, setup);
+  if (c.weighted) {
+    printf("minimum cut found: %lld total weight\n", best_cut);
+  } else {
+    printf("minimum cut found: %lld edges\n", best_cut);
+  }
 
-    //   struct timeval start, end;
-    printf("running program...\n");
-    while( true ) {
+  delete [] nodestatus;
+  return CutResult{best_cut, side};
+}
 
+// Semi-external trials for graphs whose edges do not fit in memory. Each trial keeps O(n) state: a union-find array and
+// a buffer of at most 2n keyed edges. A pass streams the file once and collects the edges between different components
+// whose keys fall in the next key range [lo, hi); hi shrinks whenever the buffer fills up. The buffer is then sorted
+// and contracted in key order, which is exactly Kruskal order, so a trial ends after O(log(m/n)) passes plus one pass
+// for the cut. All trials of a batch (one per thread) share every pass, so the disk is read once per pass.
+template <typename V>
+struct KeyedEdge {
+  unsigned key;
+  V u;
+  V v;
+};
 
-      s1 = checkcc(g, nodestatus, edgelist_cut);
+template <typename V>
+struct StreamTrial {
+  std::vector<V> nstat;
+  std::vector< KeyedEdge<V> > buf;
+  unsigned long long seed;
+  unsigned long long lo;
+  unsigned long long hi;
+  V comps;
+  long long cut;
+};
 
-      const int cc = static_cast<int>(s1.size());
-      if (cc == 2) {
-        break;
+template <typename V>
+static void stream_collect(StreamTrial<V> &t, const std::size_t capacity, const V* const __restrict__ src, const V* const __restrict__ nlist, const int* const __restrict__ eweight, const long long num, const int weighted)
+{
+  for (long long i = 0; i < num; i++) {
+    const V u = src[i];
+    const V v = nlist[i];
+    if (u < v) {
+      const unsigned key = edgekey(u, v, weighted ? eweight[i] : 1, weighted, t.seed);
+      if ((key >= t.lo) && (key < t.hi) && (representative(u, t.nstat.data()) != representative(v, t.nstat.data()))) {
+        t.buf.push_back(KeyedEdge<V>{key, u, v});
+        // keep only the smaller half of the key range when the buffer is full (unless all keys tie)
+        while ((t.buf.size() >= capacity) && (t.hi - t.lo > 1)) {
+          t.hi = t.lo + (t.hi - t.lo) / 2;
+          const unsigned long long hi = t.hi;
+          t.buf.erase(std::remove_if(t.buf.begin(), t.buf.end(), [hi](const KeyedEdge<V> &e) {return e.key >= hi;}), t.buf.end());
+        }
+      }
+    }
+  }
+}
+
+template <typename V>
+static void stream_contract(StreamTrial<V> &t)
+{
+  std::sort(t.buf.begin(), t.buf.end(), [](const KeyedEdge<V> &a, const KeyedEdge<V> &b) {return a.key < b.key;});
+  V* const nstat = t.nstat.data();
+  for (std::size_t k = 0; (k < t.buf.size()) && (t.comps > 2); k++) {
+    const V ra = representative(t.buf[k].u, nstat);
+    const V rb = representative(t.buf[k].v, nstat);
+    if (ra != rb) {
+      if (ra < rb) {
+        nstat[rb] = ra;
+      } else {
+        nstat[ra] = rb;
+      }
+      t.comps--;
+    }
+  }
+  t.buf.clear();
+  t.lo = t.hi;
+  t.hi = 1ULL << 32;
+}
+
+// stream all blocks of the file once and hand each block (with the source vertex of every slot) to all trials
+template <typename V, typename E, typename F>
+static long long stream_pass(ECLstreamT<V, E> &s, std::vector<V> &src, std::vector<V> &nlist, std::vector<int> &eweight, F visit)
+{
+  rewindECLstream(s);
+  V v = 0;
+  long long bytes = 0;
+  E num;
+  while ((num = readECLstream(s, nlist.data(), eweight.data(), (E)nlist.size())) > 0) {
+    const E first = s.next - num;
+    for (E i = 0; i < num; i++) {
+      while (s.nindex[v + 1] <= first + i) v++;
+      src[i] = v;
+    }
+    visit(num);
+    bytes += (long long)num * (sizeof(V) + (s.weighted ? sizeof(int) : 0));
+  }
+  return bytes;
+}
+
+template <typename V, typename E>
+CutResult karger(ECLstreamT<V, E> &s, const Options & opts)
+{
+  const int num_permutations = opts.num_permutations;
+  const std::size_t capacity = std::max((std::size_t)s.nodes * 2, (std::size_t)1 << 16);
+  const E block = 1 << 20;
+
+  printf("input graph: %lld nodes and %lld edges (%s)\n", (long long)s.nodes, (long long)s.edges, opts.fname);
+  printf("streaming: %lld slots per block, %lld buffered edges per trial\n", (long long)block, (long long)capacity);
+  if (opts.engine != KRUSKAL) printf("streaming always uses key-ordered contraction\n");
+
+  std::vector<V> src(block);
+  std::vector<V> nlist(block);
+  std::vector<int> eweight(s.weighted ? block : 0);
+
+  const int num_threads = thread_count();
+  std::vector< StreamTrial<V> > trials(num_threads);
+  long long best_cut = LLONG_MAX;
+  std::vector<V> best_nstat;  // the status array of the best trial is swapped out, not copied
+  long long passes = 0;
+  long long bytes = 0;
+
+  struct timeval start, end;
+  gettimeofday(&start, NULL);
+
+  for (int first = 0; first < num_permutations; first += num_threads) {
+    const int batch = std::min(num_threads, num_permutations - first);
+    for (int t = 0; t < batch; t++) {
+      StreamTrial<V> &tr = trials[t];
+      tr.nstat.resize(s.nodes);
+      std::iota(tr.nstat.begin(), tr.nstat.end(), 0);
+      tr.buf.clear();
+      tr.buf.reserve(capacity);
+      tr.seed = trial_seed(opts.seed, first + t);
+      tr.lo = 0;
+      tr.hi = 1ULL << 32;
+      tr.comps = s.nodes;
+      tr.cut = 0;
+    }
+
+    // contraction passes until every trial of the batch is down to two components
+    while (true) {
+      bool active = false;
+      for (int t = 0; t < batch; t++) {
+        active |= (trials[t].comps > 2);
       }
-      cut_size = cut_size / 2;
-      int newend;
-      if (cc < 2) {
-        newend = static_cast<int>( edgelist_cut.size() ) + std::max(cut_size, 1);
+      if (!active) break;
+
+      bytes += stream_pass(s, src, nlist, eweight, [&](const E num) {
+        #pragma omp parallel for schedule(dynamic) default(none) shared(trials, batch, capacity, src, nlist, eweight, num, s)
+        for (int t = 0; t < batch; t++) {
+          if (trials[t].comps > 2) stream_collect(trials[t], capacity, src.data(), nlist.data(), eweight.data(), (long long)num, s.weighted);
+        }
+      });
+      passes++;
+
+      for (int t = 0; t < batch; t++) {
+        StreamTrial<V> &tr = trials[t];
+        if (tr.comps > 2) {
+          if (tr.lo >= (1ULL << 32)) {fprintf(stderr, "ERROR: found 2 or more connected components in initial graph\n\n");  exit(-1);}
+          stream_contract(tr);
+        }
       }
-      else {
-        newend = static_cast<int>( edgelist_cut.size() ) - std::max(cut_size, 1);
+    }
+
+    // one more pass for the cut values
+    for (int t = 0; t < batch; t++) {
+      flatten(s.nodes, trials[t].nstat.data());
+    }
+    bytes += stream_pass(s, src, nlist, eweight, [&](const E num) {
+      #pragma omp parallel for default(none) shared(trials, batch, src, nlist, eweight, num, s)
+      for (int t = 0; t < batch; t++) {
+        const V* const nstat = trials[t].nstat.data();
+        long long cut = 0;
+        for (E i = 0; i < num; i++) {
+          if ((src[i] < nlist[i]) && (nstat[src[i]] != nstat[nlist[i]])) cut += s.weighted ? eweight[i] : 1;
+        }
+        trials[t].cut += cut;
       }
-      edgelist_cut.assign(edgelist_cut.begin(), edgelist_cut.begin() + newend);
+    });
+    passes++;
 
+    for (int t = 0; t < batch; t++) {
+      if (best_cut > trials[t].cut) {
+        best_cut = trials[t].cut;
+        best_nstat.swap(trials[t].nstat);
+      }
     }
+  }
 
-    // display_edges(edgelist_cut);
+  gettimeofday(&end, NULL);
+  double runtime = end.tv_sec + end.tv_usec / 1000000.0 - start.tv_sec - start.tv_usec / 1000000.0;
 
-    runchecks(g, nodestatus, edgelist_cut, s1);
+  printf("trial time: %.4f s\n", runtime);
+  printf("throughput: %.3f trials/s\n", num_permutations / runtime);
+  printf("passes: %lld (%.3f MB/s streamed)\n", passes, bytes * 0.000001 / runtime);
+  if (s.weighted) {
+    printf("minimum cut found: %lld total weight\n", best_cut);
+  } else {
+    printf("minimum cut found: %lld edges\n", best_cut);
+  }
 
-    // printf("edgelist cut size: %lu\n", edgelist_cut.size());
+  // without trials, there is no side
+  std::vector<char> side(best_nstat.size());
+  for (std::size_t v = 0; v < best_nstat.size(); v++) {
+    side[v] = (best_nstat[v] != best_nstat[0]);
+  }
+  return CutResult{best_cut, side};
+}
 
-    if (best_edgelist.size() > edgelist_cut.size()) {
-      // printf("new top edgelist found of length %lu \n", edgelist_cut.size());
-      best_edgelist = edgelist_cut;
+// the crossing edges of a streamed graph take two more passes over the file
+template <typename V, typename E>
+void write_cut(const char* const fname, ECLstreamT<V, E> &s, const std::vector<char> &side, const std::vector<long long>* const ids = NULL)
+{
+  const E block = 1 << 20;
+  std::vector<V> src(block);
+  std::vector<V> nlist(block);
+  std::vector<int> eweight(s.weighted ? block : 0);
+  long long value = 0;
+  stream_pass(s, src, nlist, eweight, [&](const E num) {
+    for (E i = 0; i < num; i++) {
+      if ((src[i] < nlist[i]) && (side[src[i]] != side[nlist[i]])) value += s.weighted ? eweight[i] : 1;
     }
+  });
+  FILE* const f = open_cut(fname, side, value, ids);
+  stream_pass(s, src, nlist, eweight, [&](const E num) {
+    for (E i = 0; i < num; i++) {
+      if ((src[i] < nlist[i]) && (side[src[i]] != side[nlist[i]])) print_cut_edge(f, src[i], nlist[i], s.weighted ? eweight[i] : 1, ids);
+    }
+  });
+  fclose(f);
+}
 
-    printf("program complete\n------------\n");
+// prints the smaller side of a cut in input ids
+static void report_side(const std::vector<char> &side, const std::vector<long long>* const ids)
+{
+  if (side.empty()) return;
+  const std::vector<char> s = input_side(side, ids);
+  const long long nodes = s.size();
+  const long long ones = std::count(s.begin(), s.end(), 1);
+  const char in = (2 * ones <= nodes) ? 1 : 0;
+  printf("smaller side: %lld of %lld nodes (", in ? ones : nodes - ones, nodes);
+  int listed = 0;
+  for (long long v = 0; (v < nodes) && (listed < 8); v++) {
+    if (s[v] == in) printf("%s%lld", (listed++ > 0) ? " " : "", v);
+  }
+  printf("%s)\n", (std::min(ones, nodes - ones) > 8) ? " ..." : "");
+}
+
+// relabels g in the order asked for with -r, reports the locality before and after, and saves the result with -R
+template <typename V, typename E>
+static Reordering<V, E> reorder_input(const ECLgraphT<V, E> & g, const Options & opts)
+{
+  struct timeval start, end;
+  gettimeofday(&start, NULL);
+  Reordering<V, E> r = reorder(g, opts.order);
+  gettimeofday(&end, NULL);
+  const double runtime = end.tv_sec + end.tv_usec / 1000000.0 - start.tv_sec - start.tv_usec / 1000000.0;
+  const Locality a = locality(g);
+  const Locality b = locality(r.graph);
+  printf("reordering: %s order (%.4f s)\n", order_name(opts.order), runtime);
+  printf("locality: mean log2 id gap %.2f -> %.2f, same cache line %.1f%% -> %.1f%%, same page %.1f%% -> %.1f%%\n\n", a.log_gap, b.log_gap, 100.0 * a.line, 100.0 * b.line, 100.0 * a.page, 100.0 * b.page);
+  if (opts.reorder_file != NULL) writeReordering(r, opts.reorder_file);
+  return r;
+}
 
+// load the graph in the given index layout, run the trials, and release it again
+template <typename V, typename E>
+void run(const Options & opts, const bool compressed, const long long nodes)
+{
+  // with -P, the graph was reordered before and ids[v] is the input id of its vertex v
+  std::vector<long long> ids;
+  if (opts.map_file != NULL) {
+    const std::vector<long long> map = readReorderMap(opts.map_file, nodes);
+    ids.resize(nodes);
+    for (long long v = 0; v < nodes; v++) ids[map[v]] = v;
+  }
+  const std::vector<long long>* const in = ids.empty() ? NULL : &ids;
+
+  if (opts.stream) {
+    ECLstreamT<V, E> s = openECLstream<V, E>(opts.fname);
+    const CutResult res = karger(s, opts);
+    report_side(res.side, in);
+    if ((opts.cut_file != NULL) && !res.side.empty()) write_cut(opts.cut_file, s, res.side, in);
+    closeECLstream(s);
+  } else if (compressed) {
+    ECLcgraphT<V, E> c = readECLcgraph<V, E>(opts.fname);
+    const CutResult res = karger(c, opts);
+    report_side(res.side, in);
+    if ((opts.cut_file != NULL) && !res.side.empty()) write_cut(opts.cut_file, c, res.side, in);
+    freeECLcgraph(c);
+  } else if (opts.maphints >= 0) {
+    ECLgraphT<V, E> g = mapECLgraphT<V, E>(opts.fname, opts.maphints);
+    const CutResult res = karger(g, opts);
+    report_side(res.side, in);
+    if ((opts.cut_file != NULL) && !res.side.empty()) write_cut(opts.cut_file, g, res.side, in);
+    unmapECLgraph(g);
+  } else {
+    ECLgraphT<V, E> g = readECLgraphT<V, E>(opts.fname);
+    CutResult res;
+    if (opts.order != ORDER_NONE) {
+      // the trials run on the relabeled graph, and the side of vertex v is the side of its new id
+      Reordering<V, E> r = reorder_input(g, opts);
+      res = karger(r.graph, opts);
+      if (!res.side.empty()) {
+        std::vector<char> side(g.nodes);
+        for (V v = 0; v < g.nodes; v++) side[v] = res.side[r.map[v]];
+        res.side.swap(side);
+      }
+      freeECLgraph(r.graph);
+    } else {
+      res = karger(g, opts);
+    }
+    report_side(res.side, in);
+    if ((opts.cut_file != NULL) && !res.side.empty()) write_cut(opts.cut_file, g, res.side, in);
+    freeECLgraph(g);
+  }
+}
+
+// GraphTest includes this file with ECL_NO_MAIN defined to call the engines directly
+#ifndef ECL_NO_MAIN
+int main(int argc, char* argv[])
+{
+  printf("ECL-CC v1.1 OpenMP (%s)\n", __FILE__);
+  printf("Copyright 2017-2020 Texas State University\n");
+
+  // trial engine: "kruskal" contracts the shuffled edges once, "bsearch" binary-searches the threshold with full CC passes,
+  // "hash" does the same over keys hashed from the edge ids instead of a shuffled permutation, "ks" runs one Karger-Stein recursion per permutation, "sw" computes the exact minimum cut with Stoer-Wagner
+  Options opts;
+  opts.engine = KRUSKAL;
+  // -a picks the algorithm of the CC passes: "ecl" (init, compute) or "afforest" (neighbor sampling, then only the
+  // vertices outside the giant component)
+  // -m maps the graph file instead of reading it and lets the pages fault in on first touch; -W additionally asks the
+  // kernel to read the whole file ahead, -H to back it with huge pages (both imply -m)
+  opts.maphints = -1;
+  // -s streams the edges from disk in blocks and keeps only O(n) state per trial
+  opts.stream = false;
+  // -c runs the trials on a Nagamochi-Ibaraki sparse certificate of the graph
+  opts.certificate = false;
+  // -k runs the trials on the kernel left by the Padberg-Rinaldi reductions, -K also writes it (and file.map) out
+  opts.kernel = false;
+  opts.kernel_file = NULL;
+  // -o writes the value, sides, and crossing edges of the best cut to a text file
+  opts.cut_file = NULL;
+  // -j writes the phase times and CC counters of every trial and their totals to a JSON file
+  opts.profile_file = NULL;
+  // -r relabels the vertices after loading (degree, bfs, or rcm order), -R also writes the relabeled graph (and
+  // file.map) out, and -P reads such a map so that the results of a relabeled input file come out in the original ids
+  opts.order = ORDER_NONE;
+  opts.reorder_file = NULL;
+  opts.map_file = NULL;
+  // -S sets the master seed that every trial derives its randomness from (printed, so any run can be replayed)
+  opts.seed = ((unsigned long long)std::random_device{}() << 32) | std::random_device{}();
+  // -v sets the fraction of trials whose result is verified (1 checks every trial, 0 none); the input is always checked
+  opts.verify_rate = 1.0;
+  // -x caps the vector instructions of the CC kernels (scalar, avx2, avx512); by default the widest the CPU has is used
+  const SimdLevel widest = simd_detect();
+  simd_level = widest;
+  int opt;
+  while ((opt = getopt(argc, argv, "e:a:mWHsckK:o:j:r:R:P:S:v:x:")) != -1) {
+    switch (opt) {
+      case 'e':
+        if (strcmp(optarg, "bsearch") == 0) opts.engine = BSEARCH;
+        else if (strcmp(optarg, "hash") == 0) opts.engine = HASHED;
+        else if (strcmp(optarg, "kruskal") == 0) opts.engine = KRUSKAL;
+        else if (strcmp(optarg, "ks") == 0) opts.engine = KARGER_STEIN;
+        else if (strcmp(optarg, "sw") == 0) opts.engine = STOER_WAGNER;
+        else {fprintf(stderr, "ERROR: unknown trial engine %s\n\n", optarg);  exit(-1);}
+        break;
+      case 'a':
+        if (strcmp(optarg, "ecl") == 0) cc_algorithm = CC_ECL;
+        else if (strcmp(optarg, "afforest") == 0) cc_algorithm = CC_AFFOREST;
+        else {fprintf(stderr, "ERROR: unknown CC algorithm %s\n\n", optarg);  exit(-1);}
+        break;
+      case 'm':
+        opts.maphints = std::max(opts.maphints, 0);
+        break;
+      case 'W':
+        opts.maphints = std::max(opts.maphints, 0) | ECL_MAP_READAHEAD;
+        break;
+      case 'H':
+        opts.maphints = std::max(opts.maphints, 0) | ECL_MAP_HUGEPAGE;
+        break;
+      case 's':
+        opts.stream = true;
+        break;
+      case 'c':
+        opts.certificate = true;
+        break;
+      case 'k':
+        opts.kernel = true;
+        break;
+      case 'K':
+        opts.kernel = true;
+        opts.kernel_file = optarg;
+        break;
+      case 'o':
+        opts.cut_file = optarg;
+        break;
+      case 'r': {
+        const int order = order_parse(optarg);
+        if (order < 0) {fprintf(stderr, "ERROR: unknown vertex order %s\n\n", optarg);  exit(-1);}
+        opts.order = (Order)order;
+        break;
+      }
+      case 'R':
+        opts.reorder_file = optarg;
+        break;
+      case 'P':
+        opts.map_file = optarg;
+        break;
+      case 'j':
+        if (!ECL_PROFILE) {fprintf(stderr, "ERROR: this binary was built with ECL_PROFILE=0\n\n");  exit(-1);}
+        opts.profile_file = optarg;
+        break;
+      case 'S':
+        opts.seed = strtoull(optarg, NULL, 0);
+        break;
+      case 'v':
+        opts.verify_rate = atof(optarg);
+        if ((opts.verify_rate < 0.0) || (opts.verify_rate > 1.0)) {fprintf(stderr, "ERROR: verification rate must be between 0 and 1\n\n");  exit(-1);}
+        break;
+      case 'x': {
+        const int level = simd_parse(optarg);
+        if (level < 0) {fprintf(stderr, "ERROR: unknown instruction set %s\n\n", optarg);  exit(-1);}
+        if (level > widest) {fprintf(stderr, "ERROR: this CPU does not support %s\n\n", optarg);  exit(-1);}
+        simd_level = (SimdLevel)level;
+        break;
+      }
+      default:
+        fprintf(stderr, "USAGE: %s [-e kruskal|bsearch|hash|ks|sw] [-a ecl|afforest] [-m] [-W] [-H] [-s] [-c] [-k] [-K kernel_file] [-o cut_file] [-j profile.json] [-r degree|bfs|rcm] [-R reordered_file] [-P map_file] [-S seed] [-v rate] [-x scalar|avx2|avx512] input_file_name number_permutations\n\n", argv[0]);  exit(-1);
+    }
+  }
+  if (argc - optind != 2) {fprintf(stderr, "USAGE: %s [-e kruskal|bsearch|hash|ks|sw] [-a ecl|afforest] [-m] [-W] [-H] [-s] [-c] [-k] [-K kernel_file] [-o cut_file] [-j profile.json] [-r degree|bfs|rcm] [-R reordered_file] [-P map_file] [-S seed] [-v rate] [-x scalar|avx2|avx512] input_file_name number_permutations\n\n", argv[0]);  exit(-1);}
+  opts.fname = argv[optind];
+  opts.num_permutations = std::stoi(argv[optind + 1]);
+  printf("master seed: %llu\n", opts.seed);
+  printf("vector unit: %s\n", simd_name(simd_level));
+  printf("cc algorithm: %s\n", cc_names[cc_algorithm]);
+
+  // pick the narrowest index layout that holds the graph, whatever widths the file was written with
+  ECLcheader ch;
+  const bool compressed = readECLcheader(opts.fname, ch);
+  const ECLheader h = compressed ? ECLheader{ch.magic, ch.version, 0, 0, ch.nodes, ch.edges} : readECLheader(opts.fname);
+  if ((opts.maphints >= 0) && compressed) {fprintf(stderr, "ERROR: compressed files cannot be mapped\n\n");  exit(-1);}
+  if ((opts.maphints >= 0) && (h.vbytes > h.ebytes)) {fprintf(stderr, "ERROR: files with %d-byte vertex ids and %d-byte edge offsets cannot be mapped\n\n", h.vbytes, h.ebytes);  exit(-1);}
+  if (opts.stream && (compressed || (opts.maphints >= 0))) {fprintf(stderr, "ERROR: streaming needs an uncompressed graph file and cannot be combined with mapping\n\n");  exit(-1);}
+  if ((opts.reorder_file != NULL) && (opts.order == ORDER_NONE)) {fprintf(stderr, "ERROR: -R needs a vertex order (-r)\n\n");  exit(-1);}
+  if ((opts.order != ORDER_NONE) && (compressed || opts.stream || (opts.maphints >= 0))) {fprintf(stderr, "ERROR: reordering needs the graph read into memory\n\n");  exit(-1);}
+  if ((cc_algorithm == CC_AFFOREST) && (compressed || opts.stream)) {fprintf(stderr, "ERROR: afforest needs the graph in memory\n\n");  exit(-1);}
+  if (opts.stream && (opts.profile_file != NULL)) {fprintf(stderr, "ERROR: streamed trials are not profiled\n\n");  exit(-1);}
+  if ((opts.certificate || opts.kernel) && (compressed || opts.stream)) {fprintf(stderr, "ERROR: the sparse certificate and the kernel need the graph in memory\n\n");  exit(-1);}
+  // a mapped graph keeps the widths it was written with
+  if ((opts.maphints >= 0) ? (h.vbytes == sizeof(long long)) : (h.nodes >= INT_MAX)) {
+    run<long long, long long>(opts, compressed, h.nodes);
+  } else if ((opts.maphints >= 0) ? (h.ebytes == sizeof(long long)) : (h.edges > INT_MAX)) {
+    run<int, long long>(opts, compressed, h.nodes);
+  } else {
+    run<int, int>(opts, compressed, h.nodes);
   }
 
-  delete [] nodestatus;
   return 0;
 }
+#endif
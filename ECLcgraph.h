@@ -0,0 +1,211 @@
+/*
+Compressed variant of the ECLgraph CSR format.
+
+Every vertex owns one record in a byte stream: its degree, followed by its
+sorted neighbors as varint deltas (the first one zigzag-encoded relative to
+the vertex itself) and, for weighted graphs, each edge weight as a varint.
+boff[v] is the byte offset of the record of vertex v. Typical sparse graphs
+shrink to 1-2 bytes per neighbor instead of 4 (or 8 with eweight).
+
+File layout: ECLcheader, boff (nodes + 1 long longs), byte stream.
+*/
+
+
+#ifndef ECL_CGRAPH
+#define ECL_CGRAPH
+
+#include <algorithm>
+#include <vector>
+#include "ECLgraph.h"
+
+#define ECL_CMAGIC (-0x45434c43)
+#define ECL_CVERSION 1
+
+struct ECLcheader {
+  int magic;
+  int version;
+  int weighted;
+  int reserved;
+  long long nodes;
+  long long edges;
+  long long bytes;
+};
+
+template <typename vidx_t, typename eidx_t>
+struct ECLcgraphT {
+  vidx_t nodes;
+  eidx_t edges;
+  int weighted;
+  long long* boff;
+  unsigned char* bytes;
+};
+
+static inline unsigned char* ECLputvarint(unsigned char* p, unsigned long long val)
+{
+  while (val >= 0x80) {
+    *p++ = (unsigned char)(val | 0x80);
+    val >>= 7;
+  }
+  *p++ = (unsigned char)val;
+  return p;
+}
+
+static inline const unsigned char* ECLgetvarint(const unsigned char* p, unsigned long long &val)
+{
+  unsigned long long b = *p++;
+  val = b & 0x7f;
+  int shift = 7;
+  while (b & 0x80) {
+    b = *p++;
+    val |= (b & 0x7f) << shift;
+    shift += 7;
+  }
+  return p;
+}
+
+// walks the record of one vertex; next() decodes the following neighbor (and weight) and returns false at the end
+template <typename vidx_t>
+struct ECLcdecoder {
+  const unsigned char* p;
+  unsigned long long left;
+  bool first;
+  int weighted;
+  vidx_t nbr;
+  int weight;
+
+  ECLcdecoder(const unsigned char* const bytes, const long long off, const vidx_t v, const int weighted) : first(true), weighted(weighted), nbr(v), weight(1)
+  {
+    p = ECLgetvarint(bytes + off, left);
+  }
+
+  inline bool next()
+  {
+    if (left == 0) return false;
+    unsigned long long val;
+    p = ECLgetvarint(p, val);
+    if (first) {
+      // the first delta is relative to the vertex itself and can be negative
+      nbr += (vidx_t)((long long)(val >> 1) ^ -(long long)(val & 1));
+      first = false;
+    } else {
+      nbr += (vidx_t)val;
+    }
+    if (weighted) {
+      p = ECLgetvarint(p, val);
+      weight = (int)val;
+    }
+    left--;
+    return true;
+  }
+};
+
+// encode a CSR graph; neighbor lists are sorted (together with their weights) on the fly
+template <typename vidx_t, typename eidx_t>
+ECLcgraphT<vidx_t, eidx_t> compressECLgraph(const ECLgraphT<vidx_t, eidx_t> g)
+{
+  ECLcgraphT<vidx_t, eidx_t> c;
+  c.nodes = g.nodes;
+  c.edges = g.edges;
+  c.weighted = (g.eweight != NULL);
+  c.boff = (long long*)malloc((g.nodes + 1) * sizeof(c.boff[0]));
+  if (c.boff == NULL) {fprintf(stderr, "ERROR: memory allocation failed\n\n");  exit(-1);}
+
+  std::vector< std::pair<vidx_t, int> > nbrs;
+  std::vector<unsigned char> bytes;
+  unsigned char buf[30];
+  for (vidx_t v = 0; v < g.nodes; v++) {
+    c.boff[v] = bytes.size();
+    nbrs.clear();
+    for (eidx_t i = g.nindex[v]; i < g.nindex[v + 1]; i++) {
+      nbrs.emplace_back(g.nlist[i], c.weighted ? g.eweight[i] : 1);
+    }
+    std::sort(nbrs.begin(), nbrs.end());
+    bytes.insert(bytes.end(), buf, ECLputvarint(buf, nbrs.size()));
+    vidx_t prev = v;
+    for (std::size_t k = 0; k < nbrs.size(); k++) {
+      const long long delta = (long long)nbrs[k].first - prev;
+      const unsigned long long val = (k == 0) ? (((unsigned long long)delta << 1) ^ (unsigned long long)(delta >> 63)) : (unsigned long long)delta;
+      unsigned char* p = ECLputvarint(buf, val);
+      if (c.weighted) {
+        if (nbrs[k].second < 0) {fprintf(stderr, "ERROR: found negative edge weight\n\n");  exit(-1);}
+        p = ECLputvarint(p, nbrs[k].second);
+      }
+      bytes.insert(bytes.end(), buf, p);
+      prev = nbrs[k].first;
+    }
+  }
+  c.boff[g.nodes] = bytes.size();
+
+  c.bytes = (unsigned char*)malloc(bytes.size() + 1);
+  if (c.bytes == NULL) {fprintf(stderr, "ERROR: memory allocation failed\n\n");  exit(-1);}
+  std::copy(bytes.begin(), bytes.end(), c.bytes);
+  return c;
+}
+
+// returns true and fills in the header if the file holds a compressed graph
+bool readECLcheader(const char* const fname, ECLcheader &h)
+{
+  FILE* f = fopen(fname, "rb");  if (f == NULL) {fprintf(stderr, "ERROR: could not open file %s\n\n", fname);  exit(-1);}
+  const int cnt = fread(&h, sizeof(h), 1, f);
+  fclose(f);
+  return (cnt == 1) && (h.magic == ECL_CMAGIC);
+}
+
+template <typename vidx_t, typename eidx_t>
+ECLcgraphT<vidx_t, eidx_t> readECLcgraph(const char* const fname)
+{
+  ECLcgraphT<vidx_t, eidx_t> c;
+  ECLcheader h;
+  long long cnt;
+
+  FILE* f = fopen(fname, "rb");  if (f == NULL) {fprintf(stderr, "ERROR: could not open file %s\n\n", fname);  exit(-1);}
+  cnt = fread(&h, sizeof(h), 1, f);  if (cnt != 1) {fprintf(stderr, "ERROR: failed to read header\n\n");  exit(-1);}
+  if (h.magic != ECL_CMAGIC) {fprintf(stderr, "ERROR: not a compressed graph file\n\n");  exit(-1);}
+  if (h.version != ECL_CVERSION) {fprintf(stderr, "ERROR: unsupported file version %d\n\n", h.version);  exit(-1);}
+  if ((h.nodes < 1) || (h.edges < 0) || (h.bytes < 0)) {fprintf(stderr, "ERROR: node or edge count too low\n\n");  exit(-1);}
+  if ((h.nodes >= std::numeric_limits<vidx_t>::max()) || (h.edges > std::numeric_limits<eidx_t>::max())) {fprintf(stderr, "ERROR: graph is too large for the index type\n\n");  exit(-1);}
+  c.nodes = h.nodes;
+  c.edges = h.edges;
+  c.weighted = h.weighted;
+
+  c.boff = (long long*)malloc((c.nodes + 1) * sizeof(c.boff[0]));
+  c.bytes = (unsigned char*)malloc(h.bytes + 1);
+  if ((c.boff == NULL) || (c.bytes == NULL)) {fprintf(stderr, "ERROR: memory allocation failed\n\n");  exit(-1);}
+
+  cnt = fread(c.boff, sizeof(c.boff[0]), c.nodes + 1, f);  if (cnt != c.nodes + 1) {fprintf(stderr, "ERROR: failed to read byte offsets\n\n");  exit(-1);}
+  cnt = fread(c.bytes, 1, h.bytes, f);  if (cnt != h.bytes) {fprintf(stderr, "ERROR: failed to read neighbor stream\n\n");  exit(-1);}
+  if ((c.boff[0] != 0) || (c.boff[c.nodes] != h.bytes)) {fprintf(stderr, "ERROR: byte offsets are inconsistent with stream size\n\n");  exit(-1);}
+  fclose(f);
+
+  return c;
+}
+
+template <typename vidx_t, typename eidx_t>
+void writeECLcgraph(const ECLcgraphT<vidx_t, eidx_t> c, const char* const fname)
+{
+  ECLcheader h;
+  h.magic = ECL_CMAGIC;
+  h.version = ECL_CVERSION;
+  h.weighted = c.weighted;
+  h.reserved = 0;
+  h.nodes = c.nodes;
+  h.edges = c.edges;
+  h.bytes = c.boff[c.nodes];
+  long long cnt;
+  FILE* f = fopen(fname, "wb");  if (f == NULL) {fprintf(stderr, "ERROR: could not open file %s\n\n", fname);  exit(-1);}
+  cnt = fwrite(&h, sizeof(h), 1, f);  if (cnt != 1) {fprintf(stderr, "ERROR: failed to write header\n\n");  exit(-1);}
+  cnt = fwrite(c.boff, sizeof(c.boff[0]), c.nodes + 1, f);  if (cnt != c.nodes + 1) {fprintf(stderr, "ERROR: failed to write byte offsets\n\n");  exit(-1);}
+  cnt = fwrite(c.bytes, 1, h.bytes, f);  if (cnt != h.bytes) {fprintf(stderr, "ERROR: failed to write neighbor stream\n\n");  exit(-1);}
+  fclose(f);
+}
+
+template <typename vidx_t, typename eidx_t>
+void freeECLcgraph(ECLcgraphT<vidx_t, eidx_t> &c)
+{
+  if (c.boff != NULL) free(c.boff);
+  if (c.bytes != NULL) free(c.bytes);
+  c.boff = NULL;
+  c.bytes = NULL;
+}
+
+#endif
@@ -37,15 +37,236 @@ Author: Martin Burtscher
 
 #include <cstdlib>
 #include <cstdio>
+#include <cstring>
+#include <limits>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 
-struct ECLgraph {
-  int nodes;
-  int edges;
-  int* nindex;
-  int* nlist;
+// vidx_t holds vertex ids and eidx_t holds edge offsets, so graphs with more than 2^31 edges can keep 32-bit vertex ids
+template <typename vidx_t, typename eidx_t>
+struct ECLgraphT {
+  vidx_t nodes;
+  eidx_t edges;
+  eidx_t* nindex;
+  vidx_t* nlist;
   int* eweight;
 };
 
+typedef ECLgraphT<int, int> ECLgraph;
+typedef ECLgraphT<int, long long> ECLgraph64;
+
+// Version 1 files start with the 32-bit node count. Version 2 files start with this header instead; its magic is
+// negative, so it can never be mistaken for a node count. The arrays follow in the widths given by vbytes/ebytes.
+#define ECL_MAGIC (-0x45434c47)
+#define ECL_VERSION 2
+
+struct ECLheader {
+  int magic;
+  int version;
+  int vbytes;
+  int ebytes;
+  long long nodes;
+  long long edges;
+};
+
+static ECLheader readECLheader(FILE* const f)
+{
+  ECLheader h;
+  int cnt;
+  cnt = fread(&h.magic, sizeof(h.magic), 1, f);  if (cnt != 1) {fprintf(stderr, "ERROR: failed to read nodes\n\n");  exit(-1);}
+  if (h.magic == ECL_MAGIC) {
+    cnt = fread(&h.version, sizeof(h) - sizeof(h.magic), 1, f);  if (cnt != 1) {fprintf(stderr, "ERROR: failed to read header\n\n");  exit(-1);}
+    if (h.version != ECL_VERSION) {fprintf(stderr, "ERROR: unsupported file version %d\n\n", h.version);  exit(-1);}
+    if (((h.vbytes != 4) && (h.vbytes != 8)) || ((h.ebytes != 4) && (h.ebytes != 8))) {fprintf(stderr, "ERROR: unsupported index width\n\n");  exit(-1);}
+  } else {
+    int edges;
+    cnt = fread(&edges, sizeof(edges), 1, f);  if (cnt != 1) {fprintf(stderr, "ERROR: failed to read edges\n\n");  exit(-1);}
+    h.version = 1;
+    h.vbytes = sizeof(int);
+    h.ebytes = sizeof(int);
+    h.nodes = h.magic;
+    h.edges = edges;
+  }
+  if ((h.nodes < 1) || (h.edges < 0)) {fprintf(stderr, "ERROR: node or edge count too low\n\n");  exit(-1);}
+  return h;
+}
+
+ECLheader readECLheader(const char* const fname)
+{
+  FILE* f = fopen(fname, "rb");  if (f == NULL) {fprintf(stderr, "ERROR: could not open file %s\n\n", fname);  exit(-1);}
+  const ECLheader h = readECLheader(f);
+  fclose(f);
+  return h;
+}
+
+// read count values stored with the given width into an array of type T, converting if the widths differ
+template <typename T>
+static void readECLarray(FILE* const f, T* const a, const long long count, const int bytes, const char* const what)
+{
+  if (bytes == sizeof(T)) {
+    const long long cnt = fread(a, sizeof(T), count, f);  if (cnt != count) {fprintf(stderr, "ERROR: failed to read %s\n\n", what);  exit(-1);}
+    return;
+  }
+  const long long chunk = 1 << 20;
+  char* const buf = (char*)malloc(chunk * bytes);
+  if (buf == NULL) {fprintf(stderr, "ERROR: memory allocation failed\n\n");  exit(-1);}
+  for (long long pos = 0; pos < count; pos += chunk) {
+    const long long num = (count - pos < chunk) ? (count - pos) : chunk;
+    const long long cnt = fread(buf, bytes, num, f);  if (cnt != num) {fprintf(stderr, "ERROR: failed to read %s\n\n", what);  exit(-1);}
+    for (long long i = 0; i < num; i++) {
+      long long val;
+      if (bytes == sizeof(int)) {
+        int v;
+        memcpy(&v, buf + i * bytes, sizeof(v));
+        val = v;
+      } else {
+        memcpy(&val, buf + i * bytes, sizeof(val));
+      }
+      if ((val < std::numeric_limits<T>::min()) || (val > std::numeric_limits<T>::max())) {fprintf(stderr, "ERROR: %s does not fit the index type\n\n", what);  exit(-1);}
+      a[pos + i] = (T)val;
+    }
+  }
+  free(buf);
+}
+
+// reads version 1 and version 2 files into any index layout that can hold the graph
+template <typename vidx_t, typename eidx_t>
+ECLgraphT<vidx_t, eidx_t> readECLgraphT(const char* const fname)
+{
+  ECLgraphT<vidx_t, eidx_t> g;
+  long long cnt;
+
+  FILE* f = fopen(fname, "rb");  if (f == NULL) {fprintf(stderr, "ERROR: could not open file %s\n\n", fname);  exit(-1);}
+  const ECLheader h = readECLheader(f);
+  if ((h.nodes >= std::numeric_limits<vidx_t>::max()) || (h.edges > std::numeric_limits<eidx_t>::max())) {fprintf(stderr, "ERROR: graph is too large for the index type\n\n");  exit(-1);}
+  g.nodes = h.nodes;
+  g.edges = h.edges;
+
+  g.nindex = (eidx_t*)malloc((g.nodes + 1) * sizeof(g.nindex[0]));
+  g.nlist = (vidx_t*)malloc(g.edges * sizeof(g.nlist[0]));
+  g.eweight = (int*)malloc(g.edges * sizeof(g.eweight[0]));
+  if ((g.nindex == NULL) || (g.nlist == NULL) || (g.eweight == NULL)) {fprintf(stderr, "ERROR: memory allocation failed\n\n");  exit(-1);}
+
+  readECLarray(f, g.nindex, (long long)g.nodes + 1, h.ebytes, "neighbor index list");
+  readECLarray(f, g.nlist, (long long)g.edges, h.vbytes, "neighbor list");
+  cnt = fread(g.eweight, sizeof(g.eweight[0]), g.edges, f);
+  if (cnt == 0) {
+    free(g.eweight);
+    g.eweight = NULL;
+  } else {
+    if (cnt != g.edges) {fprintf(stderr, "ERROR: failed to read edge weights\n\n");  exit(-1);}
+  }
+  fclose(f);
+
+  return g;
+}
+
+// writes a version 2 file whose index widths match the in-memory layout
+template <typename vidx_t, typename eidx_t>
+void writeECLgraphT(const ECLgraphT<vidx_t, eidx_t> g, const char* const fname)
+{
+  if ((g.nodes < 1) || (g.edges < 0)) {fprintf(stderr, "ERROR: node or edge count too low\n\n");  exit(-1);}
+  ECLheader h;
+  h.magic = ECL_MAGIC;
+  h.version = ECL_VERSION;
+  h.vbytes = sizeof(vidx_t);
+  h.ebytes = sizeof(eidx_t);
+  h.nodes = g.nodes;
+  h.edges = g.edges;
+  long long cnt;
+  FILE* f = fopen(fname, "wb");  if (f == NULL) {fprintf(stderr, "ERROR: could not open file %s\n\n", fname);  exit(-1);}
+  cnt = fwrite(&h, sizeof(h), 1, f);  if (cnt != 1) {fprintf(stderr, "ERROR: failed to write header\n\n");  exit(-1);}
+
+  cnt = fwrite(g.nindex, sizeof(g.nindex[0]), g.nodes + 1, f);  if (cnt != g.nodes + 1) {fprintf(stderr, "ERROR: failed to write neighbor index list\n\n");  exit(-1);}
+  cnt = fwrite(g.nlist, sizeof(g.nlist[0]), g.edges, f);  if (cnt != g.edges) {fprintf(stderr, "ERROR: failed to write neighbor list\n\n");  exit(-1);}
+  if (g.eweight != NULL) {
+    cnt = fwrite(g.eweight, sizeof(g.eweight[0]), g.edges, f);  if (cnt != g.edges) {fprintf(stderr, "ERROR: failed to write edge weights\n\n");  exit(-1);}
+  }
+  fclose(f);
+}
+
+// Sequential reader for graphs whose neighbor list does not fit in memory: only nindex is loaded, nlist and eweight
+// are read in blocks through two file handles. readECLstream returns the number of slots read (0 at the end).
+template <typename vidx_t, typename eidx_t>
+struct ECLstreamT {
+  vidx_t nodes;
+  eidx_t edges;
+  eidx_t* nindex;
+  int weighted;
+  int vbytes;
+  long long listpos;
+  long long weightpos;
+  eidx_t next;
+  FILE* flist;
+  FILE* fweight;
+};
+
+template <typename vidx_t, typename eidx_t>
+void rewindECLstream(ECLstreamT<vidx_t, eidx_t> &s);
+
+template <typename vidx_t, typename eidx_t>
+ECLstreamT<vidx_t, eidx_t> openECLstream(const char* const fname)
+{
+  ECLstreamT<vidx_t, eidx_t> s;
+
+  FILE* f = fopen(fname, "rb");  if (f == NULL) {fprintf(stderr, "ERROR: could not open file %s\n\n", fname);  exit(-1);}
+  const ECLheader h = readECLheader(f);
+  if ((h.nodes >= std::numeric_limits<vidx_t>::max()) || (h.edges > std::numeric_limits<eidx_t>::max())) {fprintf(stderr, "ERROR: graph is too large for the index type\n\n");  exit(-1);}
+  s.nodes = h.nodes;
+  s.edges = h.edges;
+  s.vbytes = h.vbytes;
+  s.nindex = (eidx_t*)malloc((s.nodes + 1) * sizeof(s.nindex[0]));
+  if (s.nindex == NULL) {fprintf(stderr, "ERROR: memory allocation failed\n\n");  exit(-1);}
+  readECLarray(f, s.nindex, (long long)s.nodes + 1, h.ebytes, "neighbor index list");
+
+  s.listpos = ftell(f);
+  s.weightpos = s.listpos + (long long)s.edges * h.vbytes;
+  fseek(f, 0, SEEK_END);
+  const long long size = ftell(f);
+  if (size < s.weightpos) {fprintf(stderr, "ERROR: failed to read neighbor list\n\n");  exit(-1);}
+  s.weighted = (s.edges > 0) && (size >= s.weightpos + (long long)s.edges * (long long)sizeof(int));
+  s.flist = f;
+  s.fweight = s.weighted ? fopen(fname, "rb") : NULL;
+  if (s.weighted && (s.fweight == NULL)) {fprintf(stderr, "ERROR: could not open file %s\n\n", fname);  exit(-1);}
+
+  rewindECLstream(s);
+  return s;
+}
+
+template <typename vidx_t, typename eidx_t>
+void rewindECLstream(ECLstreamT<vidx_t, eidx_t> &s)
+{
+  s.next = 0;
+  fseek(s.flist, s.listpos, SEEK_SET);
+  if (s.weighted) fseek(s.fweight, s.weightpos, SEEK_SET);
+}
+
+template <typename vidx_t, typename eidx_t>
+eidx_t readECLstream(ECLstreamT<vidx_t, eidx_t> &s, vidx_t* const nlist, int* const eweight, const eidx_t max)
+{
+  const eidx_t num = (s.edges - s.next < max) ? (s.edges - s.next) : max;
+  if (num == 0) return 0;
+  readECLarray(s.flist, nlist, (long long)num, s.vbytes, "neighbor list");
+  if (s.weighted) {
+    const long long cnt = fread(eweight, sizeof(eweight[0]), num, s.fweight);  if (cnt != num) {fprintf(stderr, "ERROR: failed to read edge weights\n\n");  exit(-1);}
+  }
+  s.next += num;
+  return num;
+}
+
+template <typename vidx_t, typename eidx_t>
+void closeECLstream(ECLstreamT<vidx_t, eidx_t> &s)
+{
+  if (s.nindex != NULL) free(s.nindex);
+  if (s.flist != NULL) fclose(s.flist);
+  if (s.fweight != NULL) fclose(s.fweight);
+  s.nindex = NULL;
+  s.flist = NULL;
+  s.fweight = NULL;
+}
+
 ECLgraph readECLgraph(const char* const fname)
 {
   ECLgraph g;
@@ -53,6 +274,10 @@ ECLgraph readECLgraph(const char* const fname)
 
   FILE* f = fopen(fname, "rb");  if (f == NULL) {fprintf(stderr, "ERROR: could not open file %s\n\n", fname);  exit(-1);}
   cnt = fread(&g.nodes, sizeof(g.nodes), 1, f);  if (cnt != 1) {fprintf(stderr, "ERROR: failed to read nodes\n\n");  exit(-1);}
+  if (g.nodes == ECL_MAGIC) {
+    fclose(f);
+    return readECLgraphT<int, int>(fname);
+  }
   cnt = fread(&g.edges, sizeof(g.edges), 1, f);  if (cnt != 1) {fprintf(stderr, "ERROR: failed to read edges\n\n");  exit(-1);}
   if ((g.nodes < 1) || (g.edges < 0)) {fprintf(stderr, "ERROR: node or edge count too low\n\n");  exit(-1);}
 
@@ -91,7 +316,79 @@ void writeECLgraph(const ECLgraph g, const char* const fname)
   fclose(f);
 }
 
-void freeECLgraph(ECLgraph &g)
+// Sequential writer for unweighted graphs that are produced in vertex order and do not fit in memory: the neighbor
+// lists of consecutive vertices are appended in blocks, and the header and nindex are filled in on close. The int/int
+// layout gives the same version 1 file as writeECLgraph, every other layout a version 2 file like writeECLgraphT.
+template <typename vidx_t, typename eidx_t>
+struct ECLwriterT {
+  vidx_t nodes;
+  vidx_t next;
+  eidx_t* nindex;
+  long long hbytes;
+  FILE* f;
+};
+
+template <typename vidx_t, typename eidx_t>
+ECLwriterT<vidx_t, eidx_t> openECLwriter(const char* const fname, const vidx_t nodes)
+{
+  if (nodes < 1) {fprintf(stderr, "ERROR: node or edge count too low\n\n");  exit(-1);}
+  ECLwriterT<vidx_t, eidx_t> w;
+  w.nodes = nodes;
+  w.next = 0;
+  w.hbytes = ((sizeof(vidx_t) == sizeof(int)) && (sizeof(eidx_t) == sizeof(int))) ? 2 * sizeof(int) : sizeof(ECLheader);
+  w.nindex = (eidx_t*)malloc((nodes + 1) * sizeof(w.nindex[0]));
+  if (w.nindex == NULL) {fprintf(stderr, "ERROR: memory allocation failed\n\n");  exit(-1);}
+  w.nindex[0] = 0;
+  w.f = fopen(fname, "wb");  if (w.f == NULL) {fprintf(stderr, "ERROR: could not open file %s\n\n", fname);  exit(-1);}
+  if (fseeko(w.f, w.hbytes + (nodes + 1LL) * sizeof(w.nindex[0]), SEEK_SET) != 0) {fprintf(stderr, "ERROR: failed to seek in file %s\n\n", fname);  exit(-1);}
+  return w;
+}
+
+// append the lists of the next 'count' vertices; nlist holds them back to back with the given degrees
+template <typename vidx_t, typename eidx_t>
+void appendECLwriter(ECLwriterT<vidx_t, eidx_t> &w, const vidx_t* const nlist, const eidx_t* const degree, const vidx_t count)
+{
+  if (w.next + count > w.nodes) {fprintf(stderr, "ERROR: too many nodes written\n\n");  exit(-1);}
+  eidx_t total = 0;
+  for (vidx_t v = 0; v < count; v++) {
+    total += degree[v];
+    w.nindex[w.next + v + 1] = w.nindex[w.next + v] + degree[v];
+  }
+  w.next += count;
+  const long long cnt = fwrite(nlist, sizeof(nlist[0]), total, w.f);  if (cnt != total) {fprintf(stderr, "ERROR: failed to write neighbor list\n\n");  exit(-1);}
+}
+
+// returns the number of edges written
+template <typename vidx_t, typename eidx_t>
+eidx_t closeECLwriter(ECLwriterT<vidx_t, eidx_t> &w)
+{
+  if (w.next != w.nodes) {fprintf(stderr, "ERROR: only %lld of %lld nodes written\n\n", (long long)w.next, (long long)w.nodes);  exit(-1);}
+  const eidx_t edges = w.nindex[w.nodes];
+  long long cnt;
+  if (fseeko(w.f, 0, SEEK_SET) != 0) {fprintf(stderr, "ERROR: failed to seek in output file\n\n");  exit(-1);}
+  if (w.hbytes == sizeof(ECLheader)) {
+    ECLheader h;
+    h.magic = ECL_MAGIC;
+    h.version = ECL_VERSION;
+    h.vbytes = sizeof(vidx_t);
+    h.ebytes = sizeof(eidx_t);
+    h.nodes = w.nodes;
+    h.edges = edges;
+    cnt = fwrite(&h, sizeof(h), 1, w.f);  if (cnt != 1) {fprintf(stderr, "ERROR: failed to write header\n\n");  exit(-1);}
+  } else {
+    const int hdr[2] = {(int)w.nodes, (int)edges};
+    cnt = fwrite(hdr, sizeof(hdr[0]), 2, w.f);  if (cnt != 2) {fprintf(stderr, "ERROR: failed to write nodes and edges\n\n");  exit(-1);}
+  }
+  cnt = fwrite(w.nindex, sizeof(w.nindex[0]), w.nodes + 1, w.f);  if (cnt != w.nodes + 1) {fprintf(stderr, "ERROR: failed to write neighbor index list\n\n");  exit(-1);}
+  fclose(w.f);
+  free(w.nindex);
+  w.f = NULL;
+  w.nindex = NULL;
+  return edges;
+}
+
+template <typename vidx_t, typename eidx_t>
+void freeECLgraph(ECLgraphT<vidx_t, eidx_t> &g)
 {
   if (g.nindex != NULL) free(g.nindex);
   if (g.nlist != NULL) free(g.nlist);
@@ -101,4 +398,85 @@ void freeECLgraph(ECLgraph &g)
   g.eweight = NULL;
 }
 
+// hints for mapECLgraph; with none, pages are read in as they are first touched
+#define ECL_MAP_READAHEAD 1  // start reading the whole file into the page cache right away
+#define ECL_MAP_HUGEPAGE 2   // ask for transparent huge pages to cut TLB misses on large graphs
+
+// map the file and point nindex/nlist/eweight straight into it instead of copying; release with unmapECLgraph
+// (the mapping is private, so the arrays can be written without touching the file or other processes' pages);
+// the index widths of the file have to be those of the layout, as nothing is converted
+template <typename vidx_t, typename eidx_t>
+ECLgraphT<vidx_t, eidx_t> mapECLgraphT(const char* const fname, const int hints = 0)
+{
+  ECLgraphT<vidx_t, eidx_t> g;
+
+  const int fd = open(fname, O_RDONLY);  if (fd < 0) {fprintf(stderr, "ERROR: could not open file %s\n\n", fname);  exit(-1);}
+  struct stat st;
+  if (fstat(fd, &st) != 0) {fprintf(stderr, "ERROR: could not stat file %s\n\n", fname);  exit(-1);}
+  const size_t size = st.st_size;
+  if (size < 2 * sizeof(int)) {fprintf(stderr, "ERROR: failed to read nodes and edges\n\n");  exit(-1);}
+
+  void* const base = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (base == MAP_FAILED) {fprintf(stderr, "ERROR: could not map file %s\n\n", fname);  exit(-1);}
+  if (hints & ECL_MAP_READAHEAD) madvise(base, size, MADV_WILLNEED);
+#ifdef MADV_HUGEPAGE
+  if (hints & ECL_MAP_HUGEPAGE) madvise(base, size, MADV_HUGEPAGE);
+#endif
+
+  // same header checks as readECLheader(), on the mapped bytes
+  ECLheader h;
+  size_t hbytes;
+  const int* const header = (const int*)base;
+  if (header[0] == ECL_MAGIC) {
+    if (size < sizeof(ECLheader)) {fprintf(stderr, "ERROR: failed to read header\n\n");  exit(-1);}
+    memcpy(&h, base, sizeof(h));
+    hbytes = sizeof(ECLheader);
+    if (h.version != ECL_VERSION) {fprintf(stderr, "ERROR: unsupported file version %d\n\n", h.version);  exit(-1);}
+  } else {
+    h.vbytes = sizeof(int);
+    h.ebytes = sizeof(int);
+    h.nodes = header[0];
+    h.edges = header[1];
+    hbytes = 2 * sizeof(int);
+  }
+  if ((h.vbytes != sizeof(vidx_t)) || (h.ebytes != sizeof(eidx_t))) {fprintf(stderr, "ERROR: index widths of the file (%d and %d bytes) do not match the mapped layout\n\n", h.vbytes, h.ebytes);  exit(-1);}
+  if ((h.nodes < 1) || (h.edges < 0)) {fprintf(stderr, "ERROR: node or edge count too low\n\n");  exit(-1);}
+  if ((h.nodes >= std::numeric_limits<vidx_t>::max()) || (h.edges > std::numeric_limits<eidx_t>::max())) {fprintf(stderr, "ERROR: graph is too large for the index type\n\n");  exit(-1);}
+  g.nodes = h.nodes;
+  g.edges = h.edges;
+
+  // the file must hold exactly the header and the CSR arrays, with or without edge weights
+  const size_t unweighted = hbytes + ((size_t)g.nodes + 1) * sizeof(eidx_t) + (size_t)g.edges * sizeof(vidx_t);
+  const size_t weighted = unweighted + (size_t)g.edges * sizeof(int);
+  if ((size != unweighted) && (size != weighted)) {fprintf(stderr, "ERROR: file size does not match node and edge counts\n\n");  exit(-1);}
+
+  g.nindex = (eidx_t*)((char*)base + hbytes);
+  g.nlist = (vidx_t*)(g.nindex + g.nodes + 1);
+  g.eweight = ((size == weighted) && (g.edges > 0)) ? (int*)(g.nlist + g.edges) : NULL;
+  if ((g.nindex[0] != 0) || (g.nindex[g.nodes] != g.edges)) {fprintf(stderr, "ERROR: neighbor index list is inconsistent with edge count\n\n");  exit(-1);}
+
+  return g;
+}
+
+ECLgraph mapECLgraph(const char* const fname, const int hints = 0)
+{
+  return mapECLgraphT<int, int>(fname, hints);
+}
+
+// the header is smaller than a page, so the mapping starts at the page that holds nindex
+template <typename vidx_t, typename eidx_t>
+void unmapECLgraph(ECLgraphT<vidx_t, eidx_t> &g)
+{
+  if (g.nindex != NULL) {
+    const size_t page = sysconf(_SC_PAGESIZE);
+    char* const base = (char*)((size_t)g.nindex & ~(page - 1));
+    const size_t size = ((char*)g.nlist - base) + (size_t)g.edges * (sizeof(vidx_t) + ((g.eweight != NULL) ? sizeof(int) : 0));
+    munmap(base, size);
+  }
+  g.nindex = NULL;
+  g.nlist = NULL;
+  g.eweight = NULL;
+}
+
 #endif
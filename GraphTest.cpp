@@ -11,11 +11,16 @@
 #define _CRT_SECURE_NO_WARNINGS
 #endif
 
+#include <fcntl.h>
+#include <sys/wait.h>
 #include <fstream>
 #include <iostream>
 #include <map>
+#include <set>
+#include <random>
 #include <vector>
 #include <string>
+#include <tuple>
 #include <boost/graph/adjacency_list.hpp>
 #include <boost/graph/connected_components.hpp>
 #include <boost/graph/exception.hpp>
@@ -26,6 +31,13 @@
 #include <boost/property_map/property_map.hpp>
 #include <boost/core/lightweight_test.hpp>
 #include <boost/tuple/tuple.hpp>
+#include "StoerWagner.h"
+#include "Kernel.h"
+#include "SimdCC.h"
+#include "Reorder.h"
+#define ECL_NO_MAIN
+#include "ECL-CC_11.cpp"
+#include "basic.cpp"
 
 typedef boost::adjacency_list< boost::vecS, boost::vecS, boost::undirectedS,
     boost::no_property, boost::property< boost::edge_weight_t, int > >
@@ -45,6 +57,237 @@ struct edge_t
     unsigned long second;
 };
 
+// CSR copy of an edge array for the native Stoer-Wagner (unit weights if ws is NULL)
+ECLgraph make_csr(const edge_t* edges, const weight_type* ws, int n, int m)
+{
+    ECLgraph g;
+    g.nodes = n;
+    g.edges = 2 * m;
+    g.nindex = (int*)calloc(n + 1, sizeof(int));
+    g.nlist = (int*)malloc(2 * m * sizeof(int));
+    g.eweight = (ws != NULL) ? (int*)malloc(2 * m * sizeof(int)) : NULL;
+    for (int e = 0; e < m; e++) {
+        g.nindex[edges[e].first + 1]++;
+        g.nindex[edges[e].second + 1]++;
+    }
+    for (int v = 0; v < n; v++) {
+        g.nindex[v + 1] += g.nindex[v];
+    }
+    std::vector< int > pos(g.nindex, g.nindex + n);
+    for (int e = 0; e < m; e++) {
+        const int a = edges[e].first, b = edges[e].second;
+        if (ws != NULL) {
+            g.eweight[pos[a]] = ws[e];
+            g.eweight[pos[b]] = ws[e];
+        }
+        g.nlist[pos[a]++] = b;
+        g.nlist[pos[b]++] = a;
+    }
+    return g;
+}
+
+// a random multigraph without self-loops for the randomized tests, with 2 to
+// maxn + 1 vertices (returned) and fewer than maxdeg edges per vertex; with
+// hubs, a quarter of the edges start at one of the first four vertices
+int random_edges(std::mt19937& engine, int maxn, int maxdeg,
+    std::vector< edge_t >& edges, bool hubs = false)
+{
+    const int n = 2 + engine() % maxn;
+    const int m = engine() % (maxdeg * n);
+    edges.resize(m);
+    for (int e = 0; e < m; e++) {
+        edges[e].first = (!hubs || (engine() % 4)) ? engine() % n : engine() % 4;
+        do {
+            edges[e].second = engine() % n;
+        } while (edges[e].second == edges[e].first);
+    }
+    return n;
+}
+
+// random_edges as a CSR graph with weights below maxw, which are kept in ws
+// (unit weights if maxw is 0)
+ECLgraph random_csr(std::mt19937& engine, int maxn, int maxdeg,
+    std::vector< edge_t >& edges, std::vector< weight_type >& ws, int maxw = 0)
+{
+    const int n = random_edges(engine, maxn, maxdeg, edges);
+    const int m = edges.size();
+    ws.resize(m);
+    for (int e = 0; e < m; e++) {
+        ws[e] = (maxw > 0) ? engine() % maxw : 1;
+    }
+    return make_csr(edges.data(), (maxw > 0) ? ws.data() : NULL, n, m);
+}
+
+// a connected simple graph on n vertices: a path plus up to extra random pairs
+// (the trial engines do not merge parallel edges)
+std::vector< edge_t > connected_edges(std::mt19937& engine, int n, int extra)
+{
+    std::set< std::pair< int, int > > pairs;
+    for (int v = 0; v + 1 < n; v++) {
+        pairs.insert(std::make_pair(v, v + 1));
+    }
+    for (int tries = extra; tries > 0; tries--) {
+        const int u = engine() % n, v = engine() % n;
+        if (u != v) pairs.insert(std::make_pair(std::min(u, v), std::max(u, v)));
+    }
+    std::vector< edge_t > edges;
+    for (const std::pair< int, int >& p : pairs) {
+        edges.push_back({ (unsigned long)p.first, (unsigned long)p.second });
+    }
+    return edges;
+}
+
+// the edge of every CSR slot of g = make_csr(edges, ...) and a random rank
+// from 0 to m for every edge, as the masked kernels take them
+void random_ranks(std::mt19937& engine, const ECLgraph& g,
+    const std::vector< edge_t >& edges, std::vector< int >& eid,
+    std::vector< int >& rank)
+{
+    const int m = edges.size();
+    std::vector< int > pos(g.nindex, g.nindex + g.nodes);
+    eid.resize(2 * m);
+    rank.resize(m);
+    for (int e = 0; e < m; e++) {
+        eid[pos[edges[e].first]++] = e;
+        eid[pos[edges[e].second]++] = e;
+        rank[e] = engine() % (m + 1);
+    }
+}
+
+// serial union-find over the edges ranked at least threshold; every vertex is
+// labeled with the smallest vertex of its component
+std::vector< int > kept_components(int n, const std::vector< edge_t >& edges,
+    const std::vector< int >& rank, int threshold)
+{
+    std::vector< int > label(n);
+    std::iota(label.begin(), label.end(), 0);
+    for (size_t e = 0; e < edges.size(); e++) {
+        if (rank[e] >= threshold) {
+            const int a = representative((int)edges[e].first, label.data());
+            const int b = representative((int)edges[e].second, label.data());
+            label[std::max(a, b)] = std::min(a, b);
+        }
+    }
+    for (int v = 0; v < n; v++) label[v] = representative(v, label.data());
+    return label;
+}
+
+// renames every component of a flattened labeling (the roots of which may be
+// any of its vertices) by its smallest vertex
+std::vector< int > smallest_labels(const std::vector< int >& nstat)
+{
+    const int n = nstat.size();
+    std::vector< int > smallest(n, n), label(n);
+    for (int v = 0; v < n; v++) smallest[nstat[v]] = std::min(smallest[nstat[v]], v);
+    for (int v = 0; v < n; v++) label[v] = smallest[nstat[v]];
+    return label;
+}
+
+// compressECLgraph has to give every vertex its sorted neighbors and weights
+// back through ECLcdecoder, and the file has to read back byte for byte
+void check_compressed(const ECLgraph& g)
+{
+    ECLcgraphT< int, int > c = compressECLgraph(g);
+    BOOST_TEST_EQ(c.nodes, g.nodes);
+    BOOST_TEST_EQ(c.edges, g.edges);
+    BOOST_TEST_EQ(c.weighted != 0, g.eweight != NULL);
+    for (int v = 0; v < g.nodes; v++) {
+        std::vector< std::pair< int, int > > expected, decoded;
+        for (int i = g.nindex[v]; i < g.nindex[v + 1]; i++) {
+            expected.push_back(std::make_pair(
+                g.nlist[i], (g.eweight != NULL) ? g.eweight[i] : 1));
+        }
+        std::sort(expected.begin(), expected.end());
+        ECLcdecoder< int > d(c.bytes, c.boff[v], v, c.weighted);
+        while (d.next()) {
+            decoded.push_back(std::make_pair(d.nbr, d.weight));
+        }
+        BOOST_TEST(decoded == expected);
+    }
+
+    const std::string fname = test_dir + "/cgraph_test.cgr";
+    writeECLcgraph(c, fname.c_str());
+    ECLcheader h;
+    BOOST_TEST(readECLcheader(fname.c_str(), h));
+    BOOST_TEST_EQ(h.bytes, c.boff[c.nodes]);
+    ECLcgraphT< int, long long > r = readECLcgraph< int, long long >(fname.c_str());
+    remove(fname.c_str());
+    BOOST_TEST_EQ(r.nodes, c.nodes);
+    BOOST_TEST_EQ(r.edges, c.edges);
+    BOOST_TEST_EQ(r.weighted, c.weighted);
+    BOOST_TEST(std::equal(c.boff, c.boff + c.nodes + 1, r.boff));
+    BOOST_TEST(std::equal(c.bytes, c.bytes + c.boff[c.nodes], r.bytes));
+    freeECLcgraph(r);
+    freeECLcgraph(c);
+}
+
+// the native engine has to find the expected weight and, for a unique minimum
+// cut, the expected sides (given as one flag per vertex)
+void check_csr(const edge_t* edges, const weight_type* ws, int n, int m,
+    int expected, const bool* sides)
+{
+    ECLgraph g = make_csr(edges, ws, n, m);
+    check_compressed(g);
+    std::vector< char > side;
+    BOOST_TEST_EQ(stoer_wagner(g, &side), expected);
+    for (int v = 0; v < n; v++) {
+        BOOST_TEST_EQ(side[v] == side[0], sides[v] == sides[0]);
+    }
+    freeECLgraph(g);
+}
+
+// cut value found by the trial engine on g (a CSR, a compressed, or a streamed
+// graph), with the engine's report sent to /dev/null; every trial is verified,
+// side receives the sides of the cut if given, and profile names the JSON
+// profile to write, if any
+template < typename G >
+long long karger_cut(G& g, Engine engine, int trials,
+    std::vector< char >* side = NULL, const char* profile = NULL)
+{
+    Options opts = {};
+    opts.engine = engine;
+    opts.maphints = -1;
+    opts.order = ORDER_NONE;
+    opts.seed = 2024;
+    opts.verify_rate = 1.0;
+    opts.fname = "test";
+    opts.num_permutations = trials;
+    opts.profile_file = profile;
+    fflush(stdout);
+    const int out = dup(1);
+    const int null = open("/dev/null", O_WRONLY);
+    dup2(null, 1);
+    const CutResult cut = karger(g, opts);
+    fflush(stdout);
+    dup2(out, 1);
+    close(null);
+    close(out);
+    if (side != NULL) *side = cut.side;
+    return cut.value;
+}
+
+// whether body stops the program with an error; it runs in a child process
+// with its output sent to /dev/null (lightweight_test aborts a child that
+// exits, as report_errors was never called there)
+template < typename F >
+bool fails(F body)
+{
+    fflush(stdout);
+    fflush(stderr);
+    const pid_t pid = fork();
+    if (pid == 0) {
+        const int null = open("/dev/null", O_WRONLY);
+        dup2(null, 1);
+        dup2(null, 2);
+        body();
+        fflush(stdout);
+        _exit(0);
+    }
+    int status;
+    waitpid(pid, &status, 0);
+    return !WIFEXITED(status) || (WEXITSTATUS(status) != 0);
+}
+
 // the example from Stoer & Wagner (1997)
 void test0()
 {
@@ -68,6 +311,8 @@ void test0()
     BOOST_TEST_EQ(parity2, get(parities, 3));
     BOOST_TEST_EQ(parity2, get(parities, 6));
     BOOST_TEST_EQ(parity2, get(parities, 7));
+    const bool sides[] = { 0, 0, 1, 1, 0, 0, 1, 1 };
+    check_csr(edges, ws, 8, 12, 4, sides);
 }
 
 void test1()
@@ -102,6 +347,8 @@ void test1()
         const bool parity2 = get(parities, 2), parity0 = get(parities, 0);
         BOOST_TEST_NE(parity2, parity0);
         BOOST_TEST_EQ(parity0, get(parities, 1));
+        const bool sides[] = { 0, 0, 1 };
+        check_csr(edges, ws, 3, 4, 3, sides);
     }
 }
 
@@ -126,6 +373,8 @@ void test2()
     BOOST_TEST_EQ(parity5, get(parities, 6));
     BOOST_TEST_EQ(parity5, get(parities, 1));
     BOOST_TEST_EQ(parity5, get(parities, 0));
+    const bool sides[] = { 1, 1, 0, 1, 0, 1, 1 };
+    check_csr(edges, ws, 7, 9, 3, sides);
 }
 
 // example by Daniel Trebbien
@@ -152,6 +401,8 @@ void test3()
     BOOST_TEST_EQ(parity0, get(parities, 4));
     BOOST_TEST_EQ(parity0, get(parities, 6));
     BOOST_TEST_EQ(parity0, get(parities, 7));
+    const bool sides[] = { 0, 1, 0, 0, 0, 1, 0, 0 };
+    check_csr(edges, ws, 8, 16, 7, sides);
 }
 
 void test4()
@@ -186,6 +437,8 @@ void test4()
     BOOST_TEST_EQ(parity2, get(parities, 3));
     BOOST_TEST_EQ(parity2, get(parities, 6));
     BOOST_TEST_EQ(parity2, get(parities, 7));
+    const bool sides[] = { 0, 0, 1, 1, 0, 0, 1, 1 };
+    check_csr(edges, NULL, 8, 14, 2, sides);
 }
 
 // Non regression test for github.com/boostorg/graph/issues/286
@@ -212,6 +465,995 @@ void test5()
     BOOST_TEST_EQ(parity4, get(parities, 5));
     BOOST_TEST_EQ(parity4, get(parities, 6));
     BOOST_TEST_EQ(parity4, get(parities, 7));
+    const bool sides[] = { 0, 0, 0, 0, 1, 1, 1, 1 };
+    check_csr(edges, ws, 8, 13, 6, sides);
+}
+
+// random small multigraphs (possibly disconnected, with zero weights) against
+// trying every bipartition, with small and large weights
+void test_csr_random()
+{
+    std::mt19937 engine(2010);
+    for (int round = 0; round < 200; round++) {
+        std::vector< edge_t > edges;
+        const int n = random_edges(engine, 11, 3, edges);
+        const int m = edges.size();
+        std::vector< weight_type > ws(m);
+        for (int e = 0; e < m; e++) {
+            ws[e] = (engine() % 10) * ((round % 2) ? 1 : 1000);  // large weights take the heap
+        }
+        int best = INT_MAX;
+        for (int mask = 1; mask < (1 << (n - 1)); mask++) {
+            int cut = 0;
+            for (int e = 0; e < m; e++) {
+                if (((mask >> edges[e].first) ^ (mask >> edges[e].second)) & 1) cut += ws[e];
+            }
+            best = std::min(best, cut);
+        }
+        ECLgraph h = make_csr(edges.data(), ws.data(), n, m);
+        BOOST_TEST_EQ(stoer_wagner(h), best);
+        long long mindeg = LLONG_MAX;
+        for (int v = 0; v < n; v++) {
+            long long deg = 0;
+            for (int i = h.nindex[v]; i < h.nindex[v + 1]; i++) deg += h.eweight[i];
+            mindeg = std::min(mindeg, deg);
+        }
+        ECLgraph c = sparse_certificate(h, mindeg);
+        BOOST_TEST_EQ(stoer_wagner(c), best);
+        freeECLgraph(c);
+        Kernel<int, int> k = kernelize(h);
+        BOOST_TEST_EQ((k.graph.nodes < 2) ? k.bound : std::min(k.bound, stoer_wagner(k.graph)), best);
+        freeECLgraph(k.graph);
+        freeECLgraph(h);
+    }
+}
+
+// components and component_labels on flattened status arrays with random
+// roots, small and spread over several counting chunks: the count has to be
+// exact up to the limit and more than the limit beyond it, and the labels have
+// to be dense, in root order, and equal exactly within a component
+void test_components()
+{
+    std::mt19937 engine(2011);
+    const int team = thread_count();
+    for (int round = 0; round < 40; round++) {
+        const int n = 1 + engine() % ((round % 2) ? 100 : 100000);
+        const int k = 1 + engine() % n;
+        std::vector< int > nstat(n), roots(n);
+        std::iota(roots.begin(), roots.end(), 0);
+        std::shuffle(roots.begin(), roots.end(), engine);
+        roots.resize(k);
+        std::sort(roots.begin(), roots.end());
+        for (int v = 0; v < n; v++) nstat[v] = roots[engine() % k];
+        for (const int r : roots) nstat[r] = r;
+
+        BOOST_TEST_EQ(components(n, nstat.data()), k);
+        BOOST_TEST_EQ(components(n, nstat.data(), k), k);
+        const int limit = engine() % k;
+        const int more = components(n, nstat.data(), limit);
+        BOOST_TEST_GT(more, limit);
+        BOOST_TEST_LE(more, k);
+#ifdef _OPENMP
+        // one thread stops after the chunk that passes the limit
+        omp_set_num_threads(1);
+        if ((n > 2 * (1 << 14)) && (roots[0] < (1 << 14)) && (roots[k - 1] >= (1 << 15))) {
+            BOOST_TEST_LT(components(n, nstat.data(), 0), k);
+        }
+        omp_set_num_threads(team);
+#endif
+
+        std::vector< int > label(n);
+        BOOST_TEST_EQ(component_labels(n, nstat.data(), label.data()), k);
+        for (int i = 0; i < k; i++) BOOST_TEST_EQ(label[roots[i]], i);
+        for (int v = 0; v < n; v++) BOOST_TEST_EQ(label[v], label[nstat[v]]);
+    }
+}
+
+// runchecks and its breadth-first verify have to accept the labels that init,
+// compute, and flatten leave and refuse them after merging two components,
+// splitting one, moving a vertex to another component, or with a wrong count
+void test_verify()
+{
+    std::mt19937 engine(2013);
+    int merged = 0, split = 0;
+    for (int round = 0; round < 60; round++) {
+        std::vector< edge_t > edges;
+        std::vector< weight_type > ws;
+        ECLgraph g = random_csr(engine, 200, 2, edges, ws);
+        const int n = g.nodes;
+        std::vector< int > eid, rank;
+        random_ranks(engine, g, edges, eid, rank);
+        const int threshold = engine() % (edges.size() + 1);
+        std::vector< int > nstat(n);
+        init(n, g.nindex, g.nlist, nstat.data(), eid.data(), rank.data(), threshold);
+        compute(n, g.nindex, g.nlist, nstat.data(), eid.data(), rank.data(), threshold);
+        flatten(n, nstat.data());
+        const int k = components(n, nstat.data());
+        const auto check = [&](const std::vector< int >& labels, const int ncomps) {
+            return fails([&]() { runchecks(g, labels.data(), eid.data(), rank.data(), threshold, ncomps); });
+        };
+        BOOST_TEST(!check(nstat, k));
+        BOOST_TEST(check(nstat, k + 1));
+
+        std::vector< int > bad(nstat);
+        bad[engine() % n] = n;
+        BOOST_TEST(check(bad, k));
+
+        // a vertex other than its root with a kept edge, which ties it to its component
+        int tied = -1;
+        for (int v = 0; (tied < 0) && (v < n); v++) {
+            for (int i = g.nindex[v]; i < g.nindex[v + 1]; i++) {
+                if ((nstat[v] != v) && (rank[eid[i]] >= threshold)) tied = v;
+            }
+        }
+        if (k >= 2) {
+            // the second component takes the label of the first, whose root it cannot reach
+            const int a = nstat[0];
+            int b = 0;
+            while (nstat[b] == a) b++;
+            b = nstat[b];
+            bad = nstat;
+            for (int v = 0; v < n; v++) {
+                if (bad[v] == b) bad[v] = a;
+            }
+            BOOST_TEST(check(bad, k - 1));
+            merged++;
+            if (tied >= 0) {
+                bad = nstat;
+                bad[tied] = (nstat[tied] == a) ? b : a;
+                BOOST_TEST(check(bad, k));
+            }
+        }
+        if (tied >= 0) {
+            // the tied vertex becomes a root of its own
+            bad = nstat;
+            bad[tied] = tied;
+            BOOST_TEST(check(bad, k + 1));
+            split++;
+        }
+        freeECLgraph(g);
+    }
+    BOOST_TEST_GT(merged, 0);
+    BOOST_TEST_GT(split, 0);
+}
+
+// the contraction engines, Karger-Stein included, on random connected simple
+// graphs with weights from 0 to 9 against Boost; weight-0 edges must never be
+// contracted ahead of the others, whatever the sign of the NaN that 0 / 0 would
+// give
+void test_weighted_engines()
+{
+    std::mt19937 engine(2005);
+    for (int round = 0; round < 40; round++) {
+        const int n = 2 + engine() % 9;
+        std::vector< edge_t > edges = connected_edges(engine, n, engine() % (2 * n));
+        const int m = edges.size();
+        std::vector< weight_type > ws(m);
+        for (int e = 0; e < m; e++) {
+            ws[e] = (engine() % 3 == 0) ? 0 : engine() % 10;
+        }
+        undirected_graph b(edges.begin(), edges.end(), ws.begin(), n, m);
+        const int expected
+            = boost::stoer_wagner_min_cut(b, get(boost::edge_weight, b));
+        ECLgraph g = make_csr(edges.data(), ws.data(), n, m);
+        for (const Engine e : { KRUSKAL, BSEARCH, HASHED }) {
+            BOOST_TEST_EQ(karger_cut(g, e, 1000), expected);
+        }
+        BOOST_TEST_EQ(karger_cut(g, KARGER_STEIN, 3), expected);
+        freeECLgraph(g);
+    }
+    // graphs above ECL_KS_BASE, so that Karger-Stein recurses before its exact base case
+    for (int round = 0; round < 10; round++) {
+        const int n = 2 * ECL_KS_BASE + engine() % 100;
+        std::vector< edge_t > edges = connected_edges(engine, n, 2 * n);
+        const int m = edges.size();
+        std::vector< weight_type > ws(m);
+        for (int e = 0; e < m; e++) {
+            ws[e] = (engine() % 3 == 0) ? 0 : engine() % 10;
+        }
+        ECLgraph g = make_csr(edges.data(), ws.data(), n, m);
+        BOOST_TEST_EQ(karger_cut(g, KARGER_STEIN, 20), stoer_wagner(g));
+        freeECLgraph(g);
+    }
+}
+
+// edgelist_create against the std::set construction it replaced, on random
+// symmetric graphs with duplicate edges and self-loops, with sorted and with
+// shuffled neighbor lists; eid has to name the edge of every CSR slot
+void test_edgelist()
+{
+    std::mt19937 engine(2010);
+    for (int round = 0; round < 50; round++) {
+        const int n = 1 + engine() % 500;
+        const int m = engine() % (4 * n);
+        std::vector< std::vector< int > > adj(n);
+        for (int e = 0; e < m; e++) {
+            const int u = engine() % n;
+            const int v = (engine() % 10) ? (int)(engine() % n) : u;
+            adj[u].push_back(v);
+            if (v != u) adj[v].push_back(u);
+        }
+        std::vector< int > nindex(n + 1, 0), nlist;
+        for (int v = 0; v < n; v++) {
+            if (round % 2) {
+                std::shuffle(adj[v].begin(), adj[v].end(), engine);
+            } else {
+                std::sort(adj[v].begin(), adj[v].end());
+            }
+            nlist.insert(nlist.end(), adj[v].begin(), adj[v].end());
+            nindex[v + 1] = nlist.size();
+        }
+
+        std::set< std::pair< int, int > > edgelist_set;
+        for (int v = 0; v < n; v++) {
+            for (int i = nindex[v]; i < nindex[v + 1]; i++) {
+                edgelist_set.insert(std::make_pair(
+                    std::min(v, nlist[i]), std::max(v, nlist[i])));
+            }
+        }
+        const std::vector< std::pair< int, int > > expected(
+            edgelist_set.begin(), edgelist_set.end());
+
+        std::vector< int > eid;
+        const std::vector< std::pair< int, int > > edgelist
+            = edgelist_create(n, nindex.data(), nlist.data(), eid);
+        BOOST_TEST(edgelist == expected);
+        BOOST_TEST_EQ(eid.size(), nlist.size());
+        for (int v = 0; v < n; v++) {
+            for (int i = nindex[v]; i < nindex[v + 1]; i++) {
+                BOOST_TEST(edgelist[eid[i]]
+                    == std::make_pair(std::min(v, nlist[i]), std::max(v, nlist[i])));
+            }
+        }
+    }
+}
+
+// varints of every length and the extremes read back with the bytes they took
+void test_varint()
+{
+    std::vector< unsigned long long > vals
+        = { 0, 1, 127, 128, 255, 16383, 16384, 0xffffffffULL, 1ULL << 63,
+              ~0ULL };
+    std::mt19937_64 engine(2008);
+    for (int i = 0; i < 1000; i++) {
+        vals.push_back(engine() >> (engine() % 64));
+    }
+    for (const unsigned long long val : vals) {
+        unsigned char buf[16];
+        const unsigned char* const end = ECLputvarint(buf, val);
+        int bits = 1;
+        while ((bits < 64) && (val >> bits)) bits++;
+        BOOST_TEST_EQ(end - buf, (bits + 6) / 7);
+        unsigned long long back;
+        BOOST_TEST(ECLgetvarint(buf, back) == end);
+        BOOST_TEST_EQ(back, val);
+    }
+}
+
+// compression of random graphs (the first delta of a vertex is often negative,
+// which takes the zigzag path), and trials on the compressed graph against the
+// same trials on the CSR graph and against Stoer-Wagner
+void test_compressed()
+{
+    std::mt19937 engine(2008);
+    for (int round = 0; round < 40; round++) {
+        const bool weighted = (round % 3) != 0;
+        std::vector< edge_t > edges;
+        std::vector< weight_type > ws;
+        ECLgraph g = random_csr(engine, (round % 4) ? 12 : 3000, 4, edges, ws, weighted ? 10 : 0);
+        const int n = g.nodes;
+        check_compressed(g);
+        freeECLgraph(g);
+        if (n > 12) continue;
+
+        std::vector< edge_t > simple = connected_edges(engine, n, edges.size());
+        ws.resize(simple.size());
+        for (size_t e = 0; e < simple.size(); e++) ws[e] = engine() % 10;
+        g = make_csr(simple.data(), weighted ? ws.data() : NULL, n, simple.size());
+        ECLcgraphT< int, int > c = compressECLgraph(g);
+        const long long cut = stoer_wagner(g);
+        BOOST_TEST_EQ(karger_cut(g, BSEARCH, 300), cut);
+        BOOST_TEST_EQ(karger_cut(c, BSEARCH, 300), cut);
+        freeECLcgraph(c);
+        freeECLgraph(g);
+    }
+}
+
+// trials on a graph streamed from its file against the same number of trials
+// on the graph in memory and against Stoer-Wagner; the sides have to give the
+// reported cut
+void test_stream()
+{
+    std::mt19937 engine(2009);
+    for (int round = 0; round < 30; round++) {
+        const int n = 2 + engine() % 40;
+        std::vector< edge_t > edges = connected_edges(engine, n, engine() % (3 * n));
+        const int m = edges.size();
+        std::vector< weight_type > ws(m);
+        for (int e = 0; e < m; e++) ws[e] = engine() % 10;
+        ECLgraph g = make_csr(edges.data(), (round % 2) ? ws.data() : NULL, n, m);
+        const std::string fname = test_dir + "/stream_test.egr";
+        writeECLgraph(g, fname.c_str());
+        ECLstreamT< int, int > st = openECLstream< int, int >(fname.c_str());
+        std::vector< char > side;
+        const long long cut = karger_cut(st, KRUSKAL, 300, &side);
+        closeECLstream(st);
+        remove(fname.c_str());
+        BOOST_TEST_EQ(cut, karger_cut(g, KRUSKAL, 300));
+        BOOST_TEST_EQ(cut, stoer_wagner(g));
+        BOOST_TEST_EQ(cut_value(g, side), cut);
+        freeECLgraph(g);
+    }
+}
+
+// contents of a cut file
+std::string read_file(const std::string& fname)
+{
+    std::ifstream in(fname.c_str());
+    return std::string(std::istreambuf_iterator< char >(in), std::istreambuf_iterator< char >());
+}
+
+// the cut file written for g (compressed and streamed as well) with the given
+// sides, with or without input ids: the header has to give the value and the
+// node count, then the side of every input vertex and the crossing edges
+void check_cut_file(const ECLgraph& g, const std::vector< char >& side,
+    const std::vector< long long >* ids)
+{
+    const std::string fname = test_dir + "/cut_test.txt";
+    const std::string gname = test_dir + "/cut_test.egr";
+    write_cut(fname.c_str(), g, side, ids);
+    std::ifstream in(fname.c_str());
+    std::string word1, word2;
+    long long value = -1, nodes = -1;
+    in >> word1 >> value >> word2 >> nodes;
+    BOOST_TEST_EQ(word1, "cut");
+    BOOST_TEST_EQ(word2, "nodes");
+    BOOST_TEST_EQ(value, cut_value(g, side));
+    BOOST_TEST_EQ(nodes, g.nodes);
+    std::vector< int > written(g.nodes);
+    for (int v = 0; v < g.nodes; v++) in >> written[v];
+    for (int v = 0; v < g.nodes; v++) {
+        BOOST_TEST_EQ(written[(ids != NULL) ? (*ids)[v] : v], side[v]);
+    }
+    std::multiset< std::tuple< long long, long long, long long > > expected, found;
+    for (int v = 0; v < g.nodes; v++) {
+        for (int i = g.nindex[v]; i < g.nindex[v + 1]; i++) {
+            const int u = g.nlist[i];
+            if ((v < u) && (side[v] != side[u])) {
+                const long long a = (ids != NULL) ? (*ids)[v] : v, b = (ids != NULL) ? (*ids)[u] : u;
+                expected.insert(std::make_tuple(std::min(a, b), std::max(a, b), (g.eweight != NULL) ? g.eweight[i] : 1));
+            }
+        }
+    }
+    long long a, b, w;
+    while (in >> a >> b >> w) found.insert(std::make_tuple(a, b, w));
+    BOOST_TEST(found == expected);
+    in.close();
+    const std::string text = read_file(fname);
+
+    ECLcgraphT< int, int > c = compressECLgraph(g);
+    write_cut(fname.c_str(), c, side, ids);
+    BOOST_TEST(read_file(fname) == text);
+    freeECLcgraph(c);
+    writeECLgraph(g, gname.c_str());
+    ECLstreamT< int, int > st = openECLstream< int, int >(gname.c_str());
+    write_cut(fname.c_str(), st, side, ids);
+    BOOST_TEST(read_file(fname) == text);
+    closeECLstream(st);
+    remove(gname.c_str());
+    remove(fname.c_str());
+}
+
+// every engine has to hand back the sides of its best trial, replayed from its
+// seed and threshold, and write_cut has to write them; without trials there is
+// nothing to replay, and the result has no sides
+void test_cut_file()
+{
+    std::mt19937 engine(2018);
+    for (int round = 0; round < 20; round++) {
+        const int n = 2 + engine() % ((round % 4) ? 30 : 80);
+        std::vector< edge_t > edges = connected_edges(engine, n, engine() % (2 * n));
+        const int m = edges.size();
+        std::vector< weight_type > ws(m);
+        for (int e = 0; e < m; e++) ws[e] = engine() % 10;
+        ECLgraph g = make_csr(edges.data(), (round % 2) ? ws.data() : NULL, n, m);
+        ECLcgraphT< int, int > c = compressECLgraph(g);
+        const long long expected = stoer_wagner(g);
+        std::vector< char > side;
+        for (const Engine e : { KRUSKAL, BSEARCH, HASHED, KARGER_STEIN }) {
+            BOOST_TEST_EQ(karger_cut(g, e, 200, &side), expected);
+            BOOST_TEST_EQ(cut_value(g, side), expected);
+            BOOST_TEST_EQ(karger_cut(g, e, 0, &side), LLONG_MAX);
+            BOOST_TEST(side.empty());
+        }
+        BOOST_TEST_EQ(karger_cut(c, BSEARCH, 0, &side), LLONG_MAX);
+        BOOST_TEST(side.empty());
+        BOOST_TEST_EQ(karger_cut(c, BSEARCH, 200, &side), expected);
+        BOOST_TEST_EQ(cut_value(g, side), expected);
+        freeECLcgraph(c);
+
+        std::vector< long long > ids(n);
+        std::iota(ids.begin(), ids.end(), 0);
+        std::shuffle(ids.begin(), ids.end(), engine);
+        check_cut_file(g, side, NULL);
+        check_cut_file(g, side, &ids);
+        freeECLgraph(g);
+    }
+}
+
+// every number that follows "key": in a JSON text, in order
+std::vector< double > json_values(const std::string& text, const std::string& key)
+{
+    std::vector< double > values;
+    const std::string pattern = "\"" + key + "\": ";
+    for (size_t at = text.find(pattern); at != std::string::npos; at = text.find(pattern, at + 1)) {
+        values.push_back(atof(text.c_str() + at + pattern.size()));
+    }
+    return values;
+}
+
+// brackets that match outside of strings, and no comma before a closing one
+bool json_balanced(const std::string& text)
+{
+    std::string open;
+    bool quoted = false;
+    char last = 0;
+    for (const char ch : text) {
+        if (quoted) {
+            quoted = (ch != '"');
+        } else if (ch == '"') {
+            quoted = true;
+        } else if ((ch == '{') || (ch == '[')) {
+            open.push_back(ch);
+        } else if ((ch == '}') || (ch == ']')) {
+            if (open.empty() || (open.back() != ((ch == '}') ? '{' : '[')) || (last == ',')) return false;
+            open.pop_back();
+        }
+        if (!isspace(ch)) last = ch;
+    }
+    return open.empty() && !quoted;
+}
+
+// the counters of compute, reduced over the threads and over the hub tasks,
+// against the work the pass has to do: every vertex that init left off its own
+// root scans its whole list and takes one representative() call for itself
+// (one per task for a hub) and one for every kept neighbor below it; and the
+// JSON profile of the trials, whose total has to add up the trials and setup
+void test_profile()
+{
+#if ECL_PROFILE
+    std::mt19937 engine(2022);
+    const int team = thread_count();
+    for (int round = 0; round < 6; round++) {
+        std::vector< edge_t > edges;
+        int n;
+        if (round % 2) {
+            n = ECL_HUB_DEGREE + 1000 + engine() % 3000;
+            for (int v = 0; v < n - 1; v++) {
+                if (engine() % 8) edges.push_back({ (unsigned long)(n - 1), (unsigned long)v });
+            }
+            for (int k = 0; k < n; k++) {
+                const int u = engine() % n, v = engine() % n;
+                if (u != v) edges.push_back({ (unsigned long)u, (unsigned long)v });
+            }
+        } else {
+            n = random_edges(engine, 3000, 6, edges);
+        }
+        const int m = edges.size();
+        ECLgraph g = make_csr(edges.data(), NULL, n, m);
+        std::vector< int > eid, rank;
+        random_ranks(engine, g, edges, eid, rank);
+        const int threshold = engine() % (m + 1);
+        std::vector< int > first(n);
+        init(n, g.nindex, g.nlist, first.data(), eid.data(), rank.data(), threshold);
+        long long slots = 0, calls = 0;
+        for (int v = 0; v < n; v++) {
+            if (first[v] == v) continue;
+            const int deg = g.nindex[v + 1] - g.nindex[v];
+            slots += deg;
+            calls += (deg > ECL_HUB_DEGREE) ? (deg + ECL_HUB_CHUNK - 1) / ECL_HUB_CHUNK : 1;
+            for (int i = g.nindex[v]; i < g.nindex[v + 1]; i++) {
+                calls += (g.nlist[i] < v) && (rank[eid[i]] >= threshold);
+            }
+        }
+        for (const int threads : { 1, 4 }) {
+#ifdef _OPENMP
+            omp_set_num_threads(threads);
+#endif
+            std::vector< int > nstat(first);
+            Profile p = {};
+            {
+                ProfileScope scope(&p);
+                compute(n, g.nindex, g.nlist, nstat.data(), eid.data(), rank.data(), threshold);
+            }
+            BOOST_TEST_EQ(p.cc.slots, slots);
+            BOOST_TEST_EQ(std::accumulate(p.cc.paths, p.cc.paths + ECL_PATH_BINS, 0LL), calls);
+            BOOST_TEST_GE(p.cc.cas, p.cc.retries);
+        }
+        freeECLgraph(g);
+    }
+#ifdef _OPENMP
+    omp_set_num_threads(team);
+#endif
+
+    const std::string fname = test_dir + "/profile_test.json";
+    for (int round = 0; round < 4; round++) {
+        const int n = 2 + engine() % 100;
+        std::vector< edge_t > edges = connected_edges(engine, n, engine() % (2 * n));
+        ECLgraph g = make_csr(edges.data(), NULL, n, edges.size());
+        ECLcgraphT< int, int > c = compressECLgraph(g);
+        const int trials = 1 + engine() % 20;
+        const Engine e = (round % 2) ? BSEARCH : KRUSKAL;
+        for (const bool compressed : { false, true }) {
+            const long long cut = compressed ? karger_cut(c, BSEARCH, trials, NULL, fname.c_str())
+                                             : karger_cut(g, e, trials, NULL, fname.c_str());
+            const std::string text = read_file(fname);
+            remove(fname.c_str());
+            BOOST_TEST(json_balanced(text));
+            BOOST_TEST(text.find(std::string("\"engine\": \"") + engine_names[compressed ? BSEARCH : e] + "\"") != std::string::npos);
+            BOOST_TEST_EQ(json_values(text, "master_seed").size(), 1u);
+            BOOST_TEST_EQ(json_values(text, "trial").size(), (size_t)trials);
+            const std::vector< double > cuts = json_values(text, "cut");
+            BOOST_TEST_EQ(*std::min_element(cuts.begin(), cuts.end()), cut);
+            // every trial, then setup, then the total
+            for (const char* const key : { "cc_passes", "slots", "cas" }) {
+                const std::vector< double > v = json_values(text, key);
+                BOOST_TEST_EQ(v.size(), (size_t)trials + 2);
+                BOOST_TEST_EQ(std::accumulate(v.begin(), v.end() - 1, 0.0), v.back());
+            }
+            BOOST_TEST_GT(json_values(text, "cc_passes").back(), 0);
+        }
+        freeECLcgraph(c);
+        freeECLgraph(g);
+    }
+#endif
+}
+
+// the file that runGenerator streams through ECLwriterT in blocks of (about)
+// p.block slots has to hold the graph built in memory
+template < typename E >
+void check_written(const GenParams& p, const ECLgraph& g)
+{
+    const std::string fname = test_dir + "/gen_test.egr";
+    std::cout.flush();
+    fflush(stdout);
+    const int out = dup(1);
+    const int null = open("/dev/null", O_WRONLY);
+    dup2(null, 1);
+    runGenerator< E >(p, fname.c_str());
+    std::cout.flush();
+    dup2(out, 1);
+    close(null);
+    close(out);
+    ECLgraph r = readECLgraphT< int, int >(fname.c_str());
+    remove(fname.c_str());
+    BOOST_TEST_EQ(r.nodes, g.nodes);
+    BOOST_TEST_EQ(r.edges, g.edges);
+    BOOST_TEST(std::equal(g.nindex, g.nindex + g.nodes + 1, r.nindex));
+    BOOST_TEST(std::equal(g.nlist, g.nlist + g.edges, r.nlist));
+    BOOST_TEST(r.eweight == NULL);
+    freeECLgraph(r);
+}
+
+// every family built in memory (R-MAT from its draws, the others from their
+// neighbor lists): the families with a known minimum cut against Stoer-Wagner
+// on instances small enough for it (planted with every cut below the degree),
+// the others connected with a minimum cut of at most the smallest degree; the
+// written file has to match with one block and with many small ones (which
+// spill R-MAT slots by block), in both index layouts
+void test_generators()
+{
+    std::vector< GenParams > params;
+    params.push_back({ COMPLETE, 9, 0, 0, 0, 0, 1, 1 << 20 });
+    params.push_back({ GRID, 12, 1, 12, 0, 0, 1, 1 << 20 });
+    params.push_back({ GRID, 35, 5, 7, 0, 0, 1, 1 << 20 });
+    params.push_back({ TORUS, 20, 4, 5, 0, 0, 1, 1 << 20 });
+    for (long long seed = 1; seed <= 4; seed++) {
+        for (long long d = 2; d <= 8; d += 2) {
+            for (long long k = 1; k < d; k++) {
+                params.push_back({ PLANTED, 2 * d + 2 + 7 * seed, 0, 0, d, k, (unsigned long long)seed, 1 << 20 });
+            }
+            params.push_back({ CYCLES, d + 1 + 13 * seed, 0, 0, d, 0, (unsigned long long)seed, 1 << 20 });
+        }
+        for (long long d = 1; d <= 16; d *= 4) {
+            params.push_back({ RMAT, 3 + 50 * seed, 0, 0, d, 0, (unsigned long long)seed, 1 << 20 });
+        }
+    }
+    params.push_back({ RMAT, 2, 0, 0, 4, 0, 5, 1 << 20 });
+    params.push_back({ RMAT, 3000, 0, 0, 8, 0, 6, 1 << 20 });
+    for (GenParams& p : params) {
+        const Generator gen(p);
+        std::vector< std::set< int > > adj(p.nodes);
+        if (p.family == RMAT) {
+            for (long long i = 0; i < gen.rmat_draws(); i++) {
+                const std::pair< long long, long long > e = gen.rmat_edge(i);
+                if (e.first != e.second) {
+                    adj[e.first].insert(e.second);
+                    adj[e.second].insert(e.first);
+                }
+            }
+        } else {
+            std::vector< long long > nbrs;
+            for (long long v = 0; v < p.nodes; v++) {
+                gen.neighbors(v, nbrs);
+                adj[v].insert(nbrs.begin(), nbrs.end());
+                BOOST_TEST_EQ(adj[v].size(), nbrs.size());
+            }
+        }
+        std::vector< int > nindex(1, 0), nlist;
+        long long mindeg = LLONG_MAX;
+        for (long long v = 0; v < p.nodes; v++) {
+            for (const int u : adj[v]) BOOST_TEST(adj[u].count(v) == 1);
+            nlist.insert(nlist.end(), adj[v].begin(), adj[v].end());
+            nindex.push_back(nlist.size());
+            mindeg = std::min(mindeg, (long long)adj[v].size());
+        }
+        BOOST_TEST_LE((long long)nlist.size(), gen.slots());
+        ECLgraph g;
+        g.nodes = p.nodes;
+        g.edges = nlist.size();
+        g.nindex = nindex.data();
+        g.nlist = nlist.data();
+        g.eweight = NULL;
+        if (gen.mincut() >= 0) {
+            BOOST_TEST_EQ(stoer_wagner(g), gen.mincut());
+        } else {
+            const long long cut = stoer_wagner(g);
+            BOOST_TEST_GE(cut, 1);
+            BOOST_TEST_LE(cut, mindeg);
+        }
+        if (p.nodes <= 200) {
+            check_written< int >(p, g);
+            p.block = 8;
+            check_written< long long >(p, g);
+        }
+    }
+}
+
+// every order of four edges has to come out of the shuffle of consecutive
+// trials about equally often: chi-square over the 24 orders (23 degrees of
+// freedom) below its 0.999 quantile of 49.7
+void test_shuffle()
+{
+    const int trials = 24000;
+    std::map< std::vector< int >, int > count;
+    std::vector< unsigned > keys;
+    std::vector< int > perm(4);
+    for (int i = 0; i < trials; i++) {
+        const unsigned long long seed = trial_seed(2019, i);
+        edge_keys(seed, keys, 4);
+        shuffle_edges(seed, perm, keys);
+        count[perm]++;
+    }
+    BOOST_TEST_EQ(count.size(), 24u);
+    const double expected = trials / 24.0;
+    double chi2 = 0.0;
+    for (const std::pair< const std::vector< int >, int >& c : count) {
+        chi2 += (c.second - expected) * (c.second - expected) / expected;
+    }
+    BOOST_TEST_LT(chi2, 49.7);
+}
+
+// copy of g in the layout V, E that shares its weights
+template < typename V, typename E >
+ECLgraphT< V, E > copy_layout(const ECLgraph& g)
+{
+    ECLgraphT< V, E > h;
+    h.nodes = g.nodes;
+    h.edges = g.edges;
+    h.nindex = (E*)malloc((g.nodes + 1) * sizeof(E));
+    h.nlist = (V*)malloc(g.edges * sizeof(V));
+    h.eweight = g.eweight;
+    std::copy(g.nindex, g.nindex + g.nodes + 1, h.nindex);
+    std::copy(g.nlist, g.nlist + g.edges, h.nlist);
+    return h;
+}
+
+// a graph written in the layout V, E (version 2, or version 1 for int, int with
+// v1 set) has to map back with the same arrays
+template < typename V, typename E >
+void check_map(const ECLgraph& g, bool v1)
+{
+    ECLgraphT< V, E > h = copy_layout< V, E >(g);
+    const std::string fname = test_dir + "/map_test.egr";
+    if (v1) {
+        writeECLgraph(g, fname.c_str());
+    } else {
+        writeECLgraphT(h, fname.c_str());
+    }
+    ECLgraphT< V, E > m = mapECLgraphT< V, E >(fname.c_str(), ECL_MAP_READAHEAD);
+    BOOST_TEST_EQ(m.nodes, h.nodes);
+    BOOST_TEST_EQ(m.edges, h.edges);
+    BOOST_TEST(std::equal(h.nindex, h.nindex + h.nodes + 1, m.nindex));
+    BOOST_TEST(std::equal(h.nlist, h.nlist + h.edges, m.nlist));
+    BOOST_TEST_EQ(m.eweight != NULL, g.eweight != NULL);
+    if ((m.eweight != NULL) && (g.eweight != NULL)) {
+        BOOST_TEST(std::equal(g.eweight, g.eweight + g.edges, m.eweight));
+    }
+    unmapECLgraph(m);
+    remove(fname.c_str());
+    free(h.nindex);
+    free(h.nlist);
+}
+
+// mapping every file layout the reader supports, with and without weights
+void test_map()
+{
+    std::mt19937 engine(2007);
+    for (int round = 0; round < 20; round++) {
+        std::vector< edge_t > edges;
+        std::vector< weight_type > ws;
+        ECLgraph g = random_csr(engine, 2000, 4, edges, ws, (round % 2) ? 10 : 0);
+        check_map< int, int >(g, true);
+        check_map< int, int >(g, false);
+        check_map< int, long long >(g, false);
+        check_map< long long, long long >(g, false);
+        freeECLgraph(g);
+    }
+}
+
+// a graph written in the file layout FV, FE (version 1 for int, int with v1
+// set) has to read back into the layout V, E with the same arrays
+template < typename FV, typename FE, typename V, typename E >
+void check_read(const ECLgraph& g, bool v1)
+{
+    ECLgraphT< FV, FE > h = copy_layout< FV, FE >(g);
+    const std::string fname = test_dir + "/read_test.egr";
+    if (v1) {
+        writeECLgraph(g, fname.c_str());
+    } else {
+        writeECLgraphT(h, fname.c_str());
+    }
+    const ECLheader header = readECLheader(fname.c_str());
+    BOOST_TEST_EQ(header.version, v1 ? 1 : ECL_VERSION);
+    BOOST_TEST_EQ(header.vbytes, (int)sizeof(FV));
+    BOOST_TEST_EQ(header.ebytes, (int)sizeof(FE));
+    ECLgraphT< V, E > r = readECLgraphT< V, E >(fname.c_str());
+    remove(fname.c_str());
+    BOOST_TEST_EQ(r.nodes, g.nodes);
+    BOOST_TEST_EQ(r.edges, g.edges);
+    BOOST_TEST(std::equal(g.nindex, g.nindex + g.nodes + 1, r.nindex));
+    BOOST_TEST(std::equal(g.nlist, g.nlist + g.edges, r.nlist));
+    BOOST_TEST_EQ(r.eweight != NULL, g.eweight != NULL);
+    if ((r.eweight != NULL) && (g.eweight != NULL)) {
+        BOOST_TEST(std::equal(g.eweight, g.eweight + g.edges, r.eweight));
+    }
+    freeECLgraph(r);
+    free(h.nindex);
+    free(h.nlist);
+}
+
+// whether reading fname into the layout V, E stops with an error
+template < typename V, typename E >
+bool read_fails(const std::string& fname)
+{
+    return fails([&]() {
+        ECLgraphT< V, E > r = readECLgraphT< V, E >(fname.c_str());
+        freeECLgraph(r);
+    });
+}
+
+// reading every file layout into every index layout, narrower ones included,
+// and refusing values and counts that the narrower layout cannot hold
+void test_read_write()
+{
+    std::mt19937 engine(2012);
+    for (int round = 0; round < 20; round++) {
+        std::vector< edge_t > edges;
+        std::vector< weight_type > ws;
+        ECLgraph g = random_csr(engine, 2000, 4, edges, ws, (round % 2) ? 10 : 0);
+        check_read< int, int, int, int >(g, true);
+        check_read< int, int, long long, long long >(g, true);
+        check_read< int, int, int, long long >(g, false);
+        check_read< int, long long, int, int >(g, false);
+        check_read< int, long long, long long, long long >(g, false);
+        check_read< long long, long long, int, int >(g, false);
+        check_read< long long, long long, int, long long >(g, false);
+        check_read< long long, int, int, long long >(g, false);
+        freeECLgraph(g);
+    }
+
+    const std::string fname = test_dir + "/narrow_test.egr";
+    long long nindex[] = { 0, 1, 2 };
+    long long nlist[] = { 1, 0 };
+    ECLgraphT< long long, long long > g = { 2, 2, nindex, nlist, NULL };
+    writeECLgraphT(g, fname.c_str());
+    BOOST_TEST((!read_fails< int, int >(fname)));
+    nlist[0] = 1LL << 33;
+    writeECLgraphT(g, fname.c_str());
+    BOOST_TEST((read_fails< int, int >(fname)));
+    BOOST_TEST((read_fails< int, long long >(fname)));
+    nlist[0] = 1;
+    nindex[2] = 1LL << 33;
+    writeECLgraphT(g, fname.c_str());
+    BOOST_TEST((read_fails< long long, int >(fname)));
+    nindex[2] = 2;
+    writeECLgraphT(g, fname.c_str());
+    // a node count above the layout only in the header, which is refused first
+    ECLheader h = readECLheader(fname.c_str());
+    h.nodes = 1LL << 32;
+    FILE* f = fopen(fname.c_str(), "r+b");
+    BOOST_TEST_EQ(fwrite(&h, sizeof(h), 1, f), 1u);
+    fclose(f);
+    BOOST_TEST((read_fails< int, int >(fname)));
+    remove(fname.c_str());
+}
+
+// the vector init and compute kernels against the scalar rules on random graphs
+// with hubs (so that full vectors and tails both occur) and random edge ranks:
+// init must pick the same parent, and compute must leave every vertex in a tree
+// rooted at the smallest vertex of its component over the kept edges
+void test_simd()
+{
+    std::mt19937 engine(2021);
+    const SimdLevel widest = simd_detect();
+    for (int round = 0; round < 100; round++) {
+        std::vector< edge_t > edges;
+        const int n = random_edges(engine, 300, 8, edges, true);
+        const int m = edges.size();
+        ECLgraph g = make_csr(edges.data(), NULL, n, m);
+        std::vector< int > eid, rank;
+        random_ranks(engine, g, edges, eid, rank);
+        const int threshold = engine() % (m + 2);
+
+        const std::vector< int > label = kept_components(n, edges, rank, threshold);
+        std::vector< int > first(n);
+        for (int v = 0; v < n; v++) {
+            first[v] = v;
+            for (int i = g.nindex[v]; (first[v] == v) && (i < g.nindex[v + 1]); i++) {
+                if (rank[eid[i]] >= threshold) first[v] = std::min(first[v], g.nlist[i]);
+            }
+        }
+
+        for (const SimdLevel level : { SIMD_AVX2, SIMD_AVX512 }) {
+            if (level > widest) continue;
+            std::vector< int > nstat(n);
+            BOOST_TEST(simd_init(level, n, g.nindex, g.nlist, nstat.data(), eid.data(), rank.data(), threshold));
+            BOOST_TEST(nstat == first);
+            simd_compute(level, n, g.nindex, g.nlist, nstat.data(), eid.data(), rank.data(), threshold);
+            for (int v = 0; v < n; v++) {
+                BOOST_TEST_EQ(representative(v, nstat.data()), label[v]);
+            }
+        }
+        freeECLgraph(g);
+    }
+}
+
+// afforest against init, compute, and flatten on random graphs with random
+// edge ranks and thresholds: both have to leave the same partition (the roots
+// may differ); low thresholds give a giant component, high ones leave none and
+// take the fallback that scans every vertex, and both branches have to occur
+void test_afforest()
+{
+    std::mt19937 engine(2024);
+    int giants = 0;
+    const int rounds = 100;
+    for (int round = 0; round < rounds; round++) {
+        std::vector< edge_t > edges;
+        std::vector< weight_type > ws;
+        ECLgraph g = random_csr(engine, 3000, 6, edges, ws);
+        const int n = g.nodes;
+        std::vector< int > eid, rank;
+        random_ranks(engine, g, edges, eid, rank);
+        const int threshold = engine() % (edges.size() + 2);
+
+        std::vector< int > sampled(n);
+        std::iota(sampled.begin(), sampled.end(), 0);
+        for (int r = 0; r < AFFOREST_ROUNDS; r++) {
+            afforest_link(n, g.nindex, g.nlist, sampled.data(), eid.data(), rank.data(), threshold, r);
+            flatten(n, sampled.data());
+        }
+        if (afforest_giant(n, sampled.data()) != n) giants++;
+
+        std::vector< int > ecl(n), aff(n);
+        init(n, g.nindex, g.nlist, ecl.data(), eid.data(), rank.data(), threshold);
+        compute(n, g.nindex, g.nlist, ecl.data(), eid.data(), rank.data(), threshold);
+        flatten(n, ecl.data());
+        afforest(n, g.nindex, g.nlist, aff.data(), eid.data(), rank.data(), threshold);
+        flatten(n, aff.data());
+
+        BOOST_TEST(smallest_labels(aff) == smallest_labels(ecl));
+        freeECLgraph(g);
+    }
+    BOOST_TEST_GT(giants, 0);
+    BOOST_TEST_LT(giants, rounds);
+}
+
+// compute, its vector versions, and afforest on graphs with hubs of more than
+// ECL_HUB_DEGREE slots, whose lists are split into tasks, against a serial
+// union-find over the kept edges, with a team of one and of four threads
+void test_hubs()
+{
+    std::mt19937 engine(2025);
+    const SimdLevel widest = simd_detect();
+    const int team = thread_count();
+    for (int round = 0; round < 6; round++) {
+        const int n = ECL_HUB_DEGREE + 2000 + engine() % 5000;
+        // the largest id as a hub links its whole list, the others only part
+        const int hub[] = { n - 1, n / 2, 0 };
+        std::vector< edge_t > edges;
+        for (int h = 0; h <= round % 3; h++) {
+            for (int v = 0; v < n; v++) {
+                if ((v != hub[h]) && (engine() % 16)) edges.push_back({ (unsigned long)hub[h], (unsigned long)v });
+            }
+        }
+        for (int k = 0; k < n / 2; k++) {
+            const int u = engine() % n, v = engine() % n;
+            if (u != v) edges.push_back({ (unsigned long)u, (unsigned long)v });
+        }
+        const int m = edges.size();
+        ECLgraph g = make_csr(edges.data(), NULL, n, m);
+        BOOST_TEST_GT(g.nindex[n] - g.nindex[n - 1], ECL_HUB_DEGREE);
+        std::vector< int > eid, rank;
+        random_ranks(engine, g, edges, eid, rank);
+        const int threshold = engine() % (m + 1);
+        const std::vector< int > label = kept_components(n, edges, rank, threshold);
+
+        for (const int threads : { 1, 4 }) {
+#ifdef _OPENMP
+            omp_set_num_threads(threads);
+#endif
+            std::vector< int > nstat(n);
+            init(n, g.nindex, g.nlist, nstat.data(), eid.data(), rank.data(), threshold);
+            compute(n, g.nindex, g.nlist, nstat.data(), eid.data(), rank.data(), threshold);
+            flatten(n, nstat.data());
+            BOOST_TEST(nstat == label);
+            for (const SimdLevel level : { SIMD_AVX2, SIMD_AVX512 }) {
+                if (level > widest) continue;
+                BOOST_TEST(simd_init(level, n, g.nindex, g.nlist, nstat.data(), eid.data(), rank.data(), threshold));
+                simd_compute(level, n, g.nindex, g.nlist, nstat.data(), eid.data(), rank.data(), threshold);
+                flatten(n, nstat.data());
+                BOOST_TEST(nstat == label);
+            }
+            // afforest may pick other roots
+            afforest(n, g.nindex, g.nlist, nstat.data(), eid.data(), rank.data(), threshold);
+            flatten(n, nstat.data());
+            BOOST_TEST(smallest_labels(nstat) == label);
+        }
+        freeECLgraph(g);
+    }
+#ifdef _OPENMP
+    omp_set_num_threads(team);
+#endif
+}
+
+// every order has to relabel with a permutation and keep the weighted edge
+// multiset, the sorted neighbor lists, and the minimum cut
+void test_reorder()
+{
+    std::mt19937 engine(2023);
+    for (int round = 0; round < 30; round++) {
+        std::vector< edge_t > edges;
+        std::vector< weight_type > ws;
+        ECLgraph g = random_csr(engine, 200, 4, edges, ws, 10);
+        const int n = g.nodes;
+        const long long cut = stoer_wagner(g);
+        for (const Order order : { ORDER_DEGREE, ORDER_BFS, ORDER_RCM }) {
+            Reordering< int, int > r = reorder(g, order);
+            std::vector< int > sorted(r.map);
+            std::sort(sorted.begin(), sorted.end());
+            for (int v = 0; v < n; v++) BOOST_TEST_EQ(sorted[v], v);
+
+            std::multiset< std::tuple< int, int, int > > before, after;
+            for (int v = 0; v < n; v++) {
+                for (int i = g.nindex[v]; i < g.nindex[v + 1]; i++) {
+                    before.insert(std::make_tuple(r.map[v], r.map[g.nlist[i]], g.eweight[i]));
+                }
+                const int k = r.map[v];
+                BOOST_TEST_EQ(r.graph.nindex[k + 1] - r.graph.nindex[k], g.nindex[v + 1] - g.nindex[v]);
+            }
+            for (int k = 0; k < n; k++) {
+                BOOST_TEST(std::is_sorted(r.graph.nlist + r.graph.nindex[k], r.graph.nlist + r.graph.nindex[k + 1]));
+                for (int i = r.graph.nindex[k]; i < r.graph.nindex[k + 1]; i++) {
+                    after.insert(std::make_tuple(k, r.graph.nlist[i], r.graph.eweight[i]));
+                }
+            }
+            BOOST_TEST(before == after);
+            BOOST_TEST_EQ(stoer_wagner(r.graph), cut);
+            freeECLgraph(r.graph);
+        }
+        freeECLgraph(g);
+    }
 }
 
 // The input for the `test_prgen` family of tests comes from a program, named
@@ -324,6 +1566,24 @@ int main(int argc, char* argv[])
         test3();
         test4();
         test5();
+        test_csr_random();
+        test_components();
+        test_verify();
+        test_weighted_engines();
+        test_map();
+        test_read_write();
+        test_edgelist();
+        test_generators();
+        test_shuffle();
+        test_varint();
+        test_compressed();
+        test_stream();
+        test_cut_file();
+        test_simd();
+        test_afforest();
+        test_hubs();
+        test_profile();
+        test_reorder();
         // test_prgen_20_70_2();
         // test_prgen_50_70_2();
     }
@@ -0,0 +1,236 @@
+/*
+Padberg-Rinaldi reductions (Padberg and Rinaldi, 1990) in front of the
+contraction trials, in the form used by Henzinger, Noe, Schulz, and Strash
+(2018). Every round merges the parallel edges of the current super graph,
+lowers the upper bound L on the minimum cut to the smallest weighted degree
+of a super vertex, and contracts the edges (u, v) that pass one of
+
+  PR1: c(u, v) >= L
+  PR2: 2 c(u, v) >= min(c(u), c(v))
+  PR3: a triangle u, v, x with 2 (c(u, v) + c(u, x)) >= c(u) and 2 (c(u, v) + c(v, x)) >= c(v)
+  PR4: c(u, v) + sum over the common neighbors x of min(c(u, x), c(v, x)) >= L
+
+PR1 and PR4 hold for every cut lighter than L, so any number of them can be
+applied at once. PR2 and PR3 only show that moving u or v across turns a cut
+that separates them into one that is no heavier, so a round applies them to a
+matching. Degree-1 and degree-2 chains fall to PR2. The rounds stop once a
+round removes less than 1/64th of the super vertices. The minimum cut of the
+input is the smaller of L and the minimum cut of the kernel.
+*/
+
+
+#ifndef ECL_KERNEL
+#define ECL_KERNEL
+
+#include <algorithm>
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+#include "ECLgraph.h"
+
+// triangle tests (PR3/PR4) skip neighbors with more super edges than this, which bounds a round at O(m * limit)
+#define ECL_KERNEL_SCAN 256
+
+template <typename vidx_t, typename eidx_t>
+struct Kernel {
+  ECLgraphT<vidx_t, eidx_t> graph;  // weighted, no parallel edges
+  std::vector<vidx_t> map;  // kernel vertex of every input vertex
+  long long bound;  // L, the lightest super vertex seen while reducing
+  std::vector<char> side;  // input vertices inside that super vertex
+  bool weighted;  // whether the input had edge weights
+  int rounds;
+};
+
+// super graph of a round in CSR form, with weighted degrees
+template <typename vidx_t, typename eidx_t>
+struct KernelCSR {
+  vidx_t nodes;
+  std::vector<eidx_t> idx;
+  std::vector<vidx_t> adj;
+  std::vector<long long> wgt;
+  std::vector<long long> deg;
+};
+
+// merges the vertices of g into 'nodes' super vertices by label, summing parallel edges and dropping loops
+template <typename vidx_t, typename eidx_t>
+static KernelCSR<vidx_t, eidx_t> kernel_relabel(const KernelCSR<vidx_t, eidx_t> &g, const std::vector<vidx_t> &label, const vidx_t nodes)
+{
+  // counting sort of the slots by their new source
+  std::vector<eidx_t> beg(nodes + 1, 0);
+  for (vidx_t v = 0; v < g.nodes; v++) {
+    beg[label[v] + 1] += g.idx[v + 1] - g.idx[v];
+  }
+  for (vidx_t a = 0; a < nodes; a++) {
+    beg[a + 1] += beg[a];
+  }
+  std::vector<eidx_t> pos(beg.begin(), beg.end() - 1);
+  std::vector<vidx_t> adj(beg[nodes]);
+  std::vector<long long> wgt(beg[nodes]);
+  for (vidx_t v = 0; v < g.nodes; v++) {
+    for (eidx_t i = g.idx[v]; i < g.idx[v + 1]; i++) {
+      const eidx_t j = pos[label[v]]++;
+      adj[j] = label[g.adj[i]];
+      wgt[j] = g.wgt[i];
+    }
+  }
+
+  // merge the targets of every new source, remembering the slot each target got
+  KernelCSR<vidx_t, eidx_t> h;
+  h.nodes = nodes;
+  h.idx.resize(nodes + 1);
+  h.deg.assign(nodes, 0);
+  std::vector<vidx_t> owner(nodes, -1);
+  std::vector<eidx_t> slot(nodes);
+  h.idx[0] = 0;
+  for (vidx_t a = 0; a < nodes; a++) {
+    for (eidx_t i = beg[a]; i < beg[a + 1]; i++) {
+      const vidx_t b = adj[i];
+      if (b == a) continue;
+      if (owner[b] != a) {
+        owner[b] = a;
+        slot[b] = (eidx_t)h.adj.size();
+        h.adj.push_back(b);
+        h.wgt.push_back(0);
+      }
+      h.wgt[slot[b]] += wgt[i];
+      h.deg[a] += wgt[i];
+    }
+    h.idx[a + 1] = (eidx_t)h.adj.size();
+  }
+  return h;
+}
+
+template <typename vidx_t>
+static vidx_t kernel_find(std::vector<vidx_t> &parent, vidx_t v)
+{
+  while (parent[v] != v) {
+    parent[v] = parent[parent[v]];
+    v = parent[v];
+  }
+  return v;
+}
+
+// one round of tests on g; returns the number of super vertices that remain and fills label
+template <typename vidx_t, typename eidx_t>
+static vidx_t kernel_round(const KernelCSR<vidx_t, eidx_t> &g, const long long bound, std::vector<vidx_t> &label)
+{
+  const vidx_t n = g.nodes;
+  std::vector<vidx_t> parent(n), owner(n, -1);
+  std::vector<long long> mark(n);
+  std::vector<char> matched(n, 0);
+  for (vidx_t v = 0; v < n; v++) parent[v] = v;
+
+  for (vidx_t a = 0; a < n; a++) {
+    for (eidx_t i = g.idx[a]; i < g.idx[a + 1]; i++) {
+      owner[g.adj[i]] = a;
+      mark[g.adj[i]] = g.wgt[i];
+    }
+    for (eidx_t i = g.idx[a]; i < g.idx[a + 1]; i++) {
+      const vidx_t b = g.adj[i];
+      if (b < a) continue;
+      const long long w = g.wgt[i];
+      bool pr4 = (w >= bound);  // PR1 is PR4 without the triangles
+      bool pr3 = !matched[a] && !matched[b] && (2 * w >= std::min(g.deg[a], g.deg[b]));  // PR2 is PR3 without the triangles
+      if (!pr4 && (g.idx[b + 1] - g.idx[b] <= ECL_KERNEL_SCAN)) {
+        long long common = w;
+        for (eidx_t j = g.idx[b]; j < g.idx[b + 1]; j++) {
+          const vidx_t x = g.adj[j];
+          if (owner[x] != a) continue;
+          common += std::min(mark[x], g.wgt[j]);
+          if ((2 * (w + mark[x]) >= g.deg[a]) && (2 * (w + g.wgt[j]) >= g.deg[b]) && !matched[a] && !matched[b]) pr3 = true;
+        }
+        pr4 = (common >= bound);
+      }
+      if (pr4 || pr3) {
+        if (!pr4) matched[a] = matched[b] = 1;
+        const vidx_t ra = kernel_find(parent, a);
+        const vidx_t rb = kernel_find(parent, b);
+        if (ra != rb) parent[std::max(ra, rb)] = std::min(ra, rb);
+      }
+    }
+  }
+
+  // dense labels in the order of the roots
+  vidx_t nodes = 0;
+  label.resize(n);
+  for (vidx_t v = 0; v < n; v++) {
+    const vidx_t r = kernel_find(parent, v);
+    label[v] = (r == v) ? nodes++ : label[r];
+  }
+  return nodes;
+}
+
+// reduces g and returns the kernel together with the mapping of the input vertices onto it
+template <typename vidx_t, typename eidx_t>
+Kernel<vidx_t, eidx_t> kernelize(const ECLgraphT<vidx_t, eidx_t> &g)
+{
+  Kernel<vidx_t, eidx_t> k;
+  k.weighted = (g.eweight != NULL);
+  k.bound = LLONG_MAX;
+  k.rounds = 0;
+  k.map.resize(g.nodes);
+  KernelCSR<vidx_t, eidx_t> cur;
+  cur.nodes = g.nodes;
+  cur.idx.assign(g.nindex, g.nindex + g.nodes + 1);
+  cur.adj.assign(g.nlist, g.nlist + g.nindex[g.nodes]);
+  cur.wgt.resize(g.nindex[g.nodes]);
+  for (eidx_t i = 0; i < g.nindex[g.nodes]; i++) {
+    cur.wgt[i] = (g.eweight != NULL) ? g.eweight[i] : 1;
+    if (cur.wgt[i] < 0) {fprintf(stderr, "ERROR: found negative edge weight\n\n");  exit(-1);}
+  }
+  for (vidx_t v = 0; v < g.nodes; v++) k.map[v] = v;
+  cur = kernel_relabel(cur, k.map, g.nodes);
+
+  std::vector<vidx_t> label;
+  bool more = true;
+  while (true) {
+    // every super vertex is one side of a cut as long as there are two of them
+    if (cur.nodes >= 2) {
+      const vidx_t a = (vidx_t)(std::min_element(cur.deg.begin(), cur.deg.end()) - cur.deg.begin());
+      if (cur.deg[a] < k.bound) {
+        k.bound = cur.deg[a];
+        k.side.assign(g.nodes, 0);
+        for (vidx_t v = 0; v < g.nodes; v++) k.side[v] = (k.map[v] == a);
+      }
+    }
+    if (!more || (cur.nodes < 2)) break;
+    const vidx_t nodes = kernel_round(cur, k.bound, label);
+    if (nodes == cur.nodes) break;
+    more = ((long long)(cur.nodes - nodes) * 64 >= cur.nodes);
+    for (vidx_t v = 0; v < g.nodes; v++) k.map[v] = label[k.map[v]];
+    cur = kernel_relabel(cur, label, nodes);
+    k.rounds++;
+  }
+
+  ECLgraphT<vidx_t, eidx_t> &h = k.graph;
+  h.nodes = cur.nodes;
+  h.edges = cur.idx[cur.nodes];
+  h.nindex = (eidx_t*)malloc((h.nodes + 1) * sizeof(h.nindex[0]));
+  h.nlist = (vidx_t*)malloc(h.edges * sizeof(h.nlist[0]) + 1);
+  h.eweight = (int*)malloc(h.edges * sizeof(h.eweight[0]) + 1);
+  if ((h.nindex == NULL) || (h.nlist == NULL) || (h.eweight == NULL)) {fprintf(stderr, "ERROR: memory allocation failed\n\n");  exit(-1);}
+  std::copy(cur.idx.begin(), cur.idx.end(), h.nindex);
+  std::copy(cur.adj.begin(), cur.adj.end(), h.nlist);
+  for (eidx_t i = 0; i < h.edges; i++) {
+    if (cur.wgt[i] > INT_MAX) {fprintf(stderr, "ERROR: merged edge weight does not fit in the kernel\n\n");  exit(-1);}
+    h.eweight[i] = (int)cur.wgt[i];
+  }
+  return k;
+}
+
+// writes the kernel as an ECL graph and, next to it, a text file with the kernel vertex of every input vertex
+template <typename vidx_t, typename eidx_t>
+void writeKernel(const Kernel<vidx_t, eidx_t> &k, const char* const fname)
+{
+  writeECLgraphT(k.graph, fname);
+  char mname[4096];
+  snprintf(mname, sizeof(mname), "%s.map", fname);
+  FILE* const f = fopen(mname, "w");  if (f == NULL) {fprintf(stderr, "ERROR: could not open file %s\n\n", mname);  exit(-1);}
+  for (std::size_t v = 0; v < k.map.size(); v++) {
+    fprintf(f, "%lld\n", (long long)k.map[v]);
+  }
+  fclose(f);
+}
+
+#endif
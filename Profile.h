@@ -0,0 +1,109 @@
+/*
+Low-overhead counters for the CC trials. Phase timers take two clock reads per
+kernel call. The hot-path counters (edge slots scanned while linking, CAS
+attempts, failed CASes, and the number of pointer hops taken by every
+representative() call in compute) are kept in registers or thread-local sums
+inside the kernels and reduced once per call. Each count is added to the
+profile of the trial that the calling thread is currently running
+(prof_current). Everything compiles away when ECL_PROFILE is
+0 (e.g., -DECL_PROFILE=0 in CMAKE_CXX_FLAGS).
+*/
+
+
+#ifndef ECL_PROFILE_H
+#define ECL_PROFILE_H
+
+#include <chrono>
+
+#ifndef ECL_PROFILE
+#define ECL_PROFILE 1
+#endif
+
+// representative() calls by hops taken: 0, 1, 2-3, 4-7, ..., 2^13 and more
+#define ECL_PATH_BINS 16
+
+enum Phase {PH_EDGELIST, PH_PERMUTATION, PH_INIT, PH_COMPUTE, PH_FLATTEN, PH_COMPONENTS, PH_VERIFY, PH_PHASES};
+
+static const char* const phase_names[PH_PHASES] = {"edgelist", "permutation", "init", "compute", "flatten", "components", "verify"};
+
+// hot-path counters of one compute() call
+struct CCcounters {
+  long long slots;
+  long long cas;
+  long long retries;
+  long long paths[ECL_PATH_BINS];
+
+  CCcounters &operator+=(const CCcounters &o)
+  {
+    slots += o.slots;
+    cas += o.cas;
+    retries += o.retries;
+    for (int b = 0; b < ECL_PATH_BINS; b++) paths[b] += o.paths[b];
+    return *this;
+  }
+};
+
+#pragma omp declare reduction(+: CCcounters: omp_out += omp_in) initializer(omp_priv = CCcounters{})
+
+static inline void count_path(CCcounters* const cnt, const long long hops)
+{
+  const int bin = (hops == 0) ? 0 : 64 - __builtin_clzll(hops);
+  cnt->paths[(bin < ECL_PATH_BINS) ? bin : ECL_PATH_BINS - 1]++;
+}
+
+// times and counts of one trial (or of the setup work outside the trials)
+struct Profile {
+  double time[PH_PHASES];
+  long long calls[PH_PHASES];
+  CCcounters cc;
+
+  Profile &operator+=(const Profile &o)
+  {
+    for (int p = 0; p < PH_PHASES; p++) {
+      time[p] += o.time[p];
+      calls[p] += o.calls[p];
+    }
+    cc += o.cc;
+    return *this;
+  }
+};
+
+// profile that the kernels called by this thread add to; NULL while nothing is being recorded
+static thread_local Profile* prof_current = NULL;
+
+static inline double prof_now()
+{
+  return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static inline void prof_phase(const Phase p, const double start)
+{
+  if (prof_current != NULL) {
+    prof_current->time[p] += prof_now() - start;
+    prof_current->calls[p]++;
+  }
+}
+
+static inline void prof_counters(const CCcounters &cnt)
+{
+  if (prof_current != NULL) prof_current->cc += cnt;
+}
+
+// points prof_current at p while it lives and restores the previous profile afterwards
+struct ProfileScope {
+  Profile* const prev;
+  explicit ProfileScope(Profile* const p) : prev(prof_current) {prof_current = p;}
+  ~ProfileScope() {prof_current = prev;}
+};
+
+#if ECL_PROFILE
+#define PROF_START(t) const double t = prof_now()
+#define PROF_PHASE(p, t) prof_phase(p, t)
+#define PROF_COUNT(stmt) stmt
+#else
+#define PROF_START(t)
+#define PROF_PHASE(p, t)
+#define PROF_COUNT(stmt)
+#endif
+
+#endif
@@ -0,0 +1,246 @@
+/*
+Vertex reorderings that put vertices which are adjacent in the graph close
+together in the id space. This helps the union-find walks over nstat in
+ECL-CC, because the parent of a vertex and its neighbors then tend to share
+cache lines and pages. Three orders are offered:
+
+  degree: by decreasing degree, so the hubs (touched by most hooks) share the
+          first lines of nstat
+  bfs:    breadth-first from the highest-degree vertex of every component
+  rcm:    reverse Cuthill-McKee (Cuthill and McKee, 1969), i.e., breadth-first
+          from a low-degree peripheral vertex with the neighbors visited by
+          increasing degree, reversed; it keeps the id gaps of the edges small
+
+A reordering is a map from the input ids to the new ids. The relabeled graph
+gets sorted neighbor lists, keeps the edge weights, and can be written out
+together with the map (writeReordering) so that later runs load it directly
+and translate their results back with readReorderMap.
+*/
+
+
+#ifndef ECL_REORDER
+#define ECL_REORDER
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <utility>
+#include <vector>
+#include "ECLgraph.h"
+
+enum Order {ORDER_NONE, ORDER_DEGREE, ORDER_BFS, ORDER_RCM};
+
+static inline const char* order_name(const Order order)
+{
+  return (order == ORDER_DEGREE) ? "degree" : (order == ORDER_BFS) ? "bfs" : (order == ORDER_RCM) ? "rcm" : "none";
+}
+
+// order named 'name', or -1 if there is no such order
+static inline int order_parse(const char* const name)
+{
+  for (const Order order : {ORDER_DEGREE, ORDER_BFS, ORDER_RCM}) {
+    if (strcmp(name, order_name(order)) == 0) return order;
+  }
+  return -1;
+}
+
+template <typename vidx_t, typename eidx_t>
+struct Reordering {
+  ECLgraphT<vidx_t, eidx_t> graph;  // the input graph under the new ids
+  std::vector<vidx_t> map;  // new id of every input vertex
+};
+
+// Locality of the vertex ids of a graph: the mean log2 gap |u - v| + 1 over the edge slots, and the share of slots
+// whose endpoints have their 4-byte nstat entries in the same 64-byte cache line or the same 4 KB page.
+struct Locality {
+  double log_gap;
+  double line;
+  double page;
+};
+
+template <typename vidx_t, typename eidx_t>
+Locality locality(const ECLgraphT<vidx_t, eidx_t> &g)
+{
+  double log_gap = 0.0;
+  long long line = 0, page = 0;
+  #pragma omp parallel for schedule(guided) default(none) shared(g) reduction(+: log_gap, line, page)
+  for (vidx_t v = 0; v < g.nodes; v++) {
+    for (eidx_t i = g.nindex[v]; i < g.nindex[v + 1]; i++) {
+      const vidx_t u = g.nlist[i];
+      const unsigned long long gap = (u > v) ? u - v : v - u;
+      log_gap += 64 - __builtin_clzll(gap + 1) - 1;
+      line += (u / 16 == v / 16);
+      page += (u / 1024 == v / 1024);
+    }
+  }
+  const double slots = (double)std::max(g.nindex[g.nodes], (eidx_t)1);
+  return Locality{log_gap / slots, line / slots, page / slots};
+}
+
+// breadth-first order of the component of 'root', appended to 'order'; with 'by_degree', the neighbors of every vertex
+// are visited by increasing degree (Cuthill-McKee)
+template <typename vidx_t, typename eidx_t>
+static void reorder_bfs(const ECLgraphT<vidx_t, eidx_t> &g, const vidx_t root, const bool by_degree, std::vector<char> &seen, std::vector<vidx_t> &order)
+{
+  std::vector<vidx_t> next;
+  std::size_t head = order.size();
+  order.push_back(root);
+  seen[root] = 1;
+  while (head < order.size()) {
+    const vidx_t v = order[head++];
+    next.clear();
+    for (eidx_t i = g.nindex[v]; i < g.nindex[v + 1]; i++) {
+      const vidx_t u = g.nlist[i];
+      if (!seen[u]) {
+        seen[u] = 1;
+        next.push_back(u);
+      }
+    }
+    if (by_degree) {
+      std::stable_sort(next.begin(), next.end(), [&g](const vidx_t a, const vidx_t b) {return g.nindex[a + 1] - g.nindex[a] < g.nindex[b + 1] - g.nindex[b];});
+    }
+    order.insert(order.end(), next.begin(), next.end());
+  }
+}
+
+// vertex of the component of 'root' that a breadth-first search from root reaches last, with the lowest degree among
+// those at that distance (one step of the George-Liu pseudo-peripheral vertex search)
+template <typename vidx_t, typename eidx_t>
+static vidx_t reorder_far(const ECLgraphT<vidx_t, eidx_t> &g, const vidx_t root, std::vector<vidx_t> &dist, std::vector<vidx_t> &queue)
+{
+  queue.clear();
+  queue.push_back(root);
+  dist[root] = 0;
+  vidx_t far = root;
+  for (std::size_t head = 0; head < queue.size(); head++) {
+    const vidx_t v = queue[head];
+    if ((dist[v] > dist[far]) || ((dist[v] == dist[far]) && (g.nindex[v + 1] - g.nindex[v] < g.nindex[far + 1] - g.nindex[far]))) far = v;
+    for (eidx_t i = g.nindex[v]; i < g.nindex[v + 1]; i++) {
+      const vidx_t u = g.nlist[i];
+      if (dist[u] < 0) {
+        dist[u] = dist[v] + 1;
+        queue.push_back(u);
+      }
+    }
+  }
+  for (const vidx_t v : queue) dist[v] = -1;
+  return far;
+}
+
+// new id of every vertex under the given order
+template <typename vidx_t, typename eidx_t>
+std::vector<vidx_t> reorder_map(const ECLgraphT<vidx_t, eidx_t> &g, const Order order)
+{
+  const vidx_t n = g.nodes;
+  std::vector<vidx_t> seq;
+  seq.reserve(n);
+  if (order == ORDER_DEGREE) {
+    for (vidx_t v = 0; v < n; v++) seq.push_back(v);
+    std::stable_sort(seq.begin(), seq.end(), [&g](const vidx_t a, const vidx_t b) {return g.nindex[a + 1] - g.nindex[a] > g.nindex[b + 1] - g.nindex[b];});
+  } else {
+    // every component starts from its highest-degree vertex (bfs) or from a peripheral vertex found from there (rcm)
+    std::vector<vidx_t> roots(n);
+    for (vidx_t v = 0; v < n; v++) roots[v] = v;
+    std::stable_sort(roots.begin(), roots.end(), [&g](const vidx_t a, const vidx_t b) {return g.nindex[a + 1] - g.nindex[a] > g.nindex[b + 1] - g.nindex[b];});
+    std::vector<char> seen(n, 0);
+    std::vector<vidx_t> dist, queue;
+    if (order == ORDER_RCM) dist.assign(n, -1);
+    for (const vidx_t r : roots) {
+      if (seen[r]) continue;
+      vidx_t root = r;
+      if (order == ORDER_RCM) {
+        root = reorder_far(g, reorder_far(g, r, dist, queue), dist, queue);
+      }
+      const std::size_t beg = seq.size();
+      reorder_bfs(g, root, order == ORDER_RCM, seen, seq);
+      if (order == ORDER_RCM) std::reverse(seq.begin() + beg, seq.end());
+    }
+  }
+  std::vector<vidx_t> map(n);
+  for (vidx_t k = 0; k < n; k++) map[seq[k]] = k;
+  return map;
+}
+
+// g under the new ids, with sorted neighbor lists
+template <typename vidx_t, typename eidx_t>
+ECLgraphT<vidx_t, eidx_t> reorder_graph(const ECLgraphT<vidx_t, eidx_t> &g, const std::vector<vidx_t> &map)
+{
+  const vidx_t n = g.nodes;
+  std::vector<vidx_t> old(n);
+  for (vidx_t v = 0; v < n; v++) old[map[v]] = v;
+
+  ECLgraphT<vidx_t, eidx_t> h;
+  h.nodes = n;
+  h.edges = g.edges;
+  h.nindex = (eidx_t*)malloc((n + 1) * sizeof(h.nindex[0]));
+  h.nlist = (vidx_t*)malloc(h.edges * sizeof(h.nlist[0]) + 1);
+  h.eweight = (g.eweight != NULL) ? (int*)malloc(h.edges * sizeof(h.eweight[0]) + 1) : NULL;
+  if ((h.nindex == NULL) || (h.nlist == NULL) || ((g.eweight != NULL) && (h.eweight == NULL))) {fprintf(stderr, "ERROR: memory allocation failed\n\n");  exit(-1);}
+  h.nindex[0] = 0;
+  for (vidx_t k = 0; k < n; k++) {
+    h.nindex[k + 1] = h.nindex[k] + (g.nindex[old[k] + 1] - g.nindex[old[k]]);
+  }
+
+  #pragma omp parallel for schedule(guided) default(none) shared(g, h, n, map, old)
+  for (vidx_t k = 0; k < n; k++) {
+    const vidx_t v = old[k];
+    const eidx_t beg = h.nindex[k];
+    const eidx_t deg = g.nindex[v + 1] - g.nindex[v];
+    if (h.eweight == NULL) {
+      for (eidx_t j = 0; j < deg; j++) h.nlist[beg + j] = map[g.nlist[g.nindex[v] + j]];
+      std::sort(h.nlist + beg, h.nlist + beg + deg);
+    } else {
+      std::vector< std::pair<vidx_t, int> > adj(deg);
+      for (eidx_t j = 0; j < deg; j++) adj[j] = std::make_pair(map[g.nlist[g.nindex[v] + j]], g.eweight[g.nindex[v] + j]);
+      std::sort(adj.begin(), adj.end());
+      for (eidx_t j = 0; j < deg; j++) {
+        h.nlist[beg + j] = adj[j].first;
+        h.eweight[beg + j] = adj[j].second;
+      }
+    }
+  }
+  return h;
+}
+
+template <typename vidx_t, typename eidx_t>
+Reordering<vidx_t, eidx_t> reorder(const ECLgraphT<vidx_t, eidx_t> &g, const Order order)
+{
+  Reordering<vidx_t, eidx_t> r;
+  r.map = reorder_map(g, order);
+  r.graph = reorder_graph(g, r.map);
+  return r;
+}
+
+// writes the reordered graph as an ECL graph and, next to it, a text file with the new id of every input vertex
+template <typename vidx_t, typename eidx_t>
+void writeReordering(const Reordering<vidx_t, eidx_t> &r, const char* const fname)
+{
+  writeECLgraphT(r.graph, fname);
+  char mname[4096];
+  snprintf(mname, sizeof(mname), "%s.map", fname);
+  FILE* const f = fopen(mname, "w");  if (f == NULL) {fprintf(stderr, "ERROR: could not open file %s\n\n", mname);  exit(-1);}
+  for (std::size_t v = 0; v < r.map.size(); v++) {
+    fprintf(f, "%lld\n", (long long)r.map[v]);
+  }
+  fclose(f);
+}
+
+// the map written by writeReordering for a graph of 'nodes' vertices; exits unless it is a permutation
+static inline std::vector<long long> readReorderMap(const char* const fname, const long long nodes)
+{
+  FILE* const f = fopen(fname, "r");  if (f == NULL) {fprintf(stderr, "ERROR: could not open file %s\n\n", fname);  exit(-1);}
+  std::vector<long long> map;
+  std::vector<char> hit(nodes, 0);
+  long long id;
+  while (fscanf(f, "%lld", &id) == 1) {
+    if ((id < 0) || (id >= nodes) || hit[id]) {fprintf(stderr, "ERROR: %s is not a permutation of the %lld nodes\n\n", fname, nodes);  exit(-1);}
+    hit[id] = 1;
+    map.push_back(id);
+  }
+  fclose(f);
+  if ((long long)map.size() != nodes) {fprintf(stderr, "ERROR: %s is not a permutation of the %lld nodes\n\n", fname, nodes);  exit(-1);}
+  return map;
+}
+
+#endif
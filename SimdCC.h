@@ -0,0 +1,303 @@
+/*
+Vector versions of the two edge scans of ECL-CC for the 32-bit layout with a
+rank array: init, which takes the first kept neighbor below v as the initial
+parent, and compute, which filters the kept neighbors below v and hooks them.
+An AVX2 loop handles 8 slots per step and an AVX-512 loop 16. Each step loads
+the neighbor ids, compares them with v, and gathers the ranks of only the
+lanes that passed (a masked gather), because only those lanes can be chosen or
+hooked. The set lanes of the resulting mask are then taken in slot order, so
+init produces exactly the labels of the scalar loop, and compute makes the same
+hooks in the same order. Slots past the last full vector go through the scalar
+loop. Hubs are split into chunks that run as tasks (hub_tasks), as in the
+scalar compute. The level is picked from cpuid at run time (simd_detect). The vector
+functions are compiled with target attributes, so the rest of the program needs
+no -mavx flags and still runs on machines without the instructions.
+*/
+
+
+#ifndef ECL_SIMD_CC
+#define ECL_SIMD_CC
+
+#include <algorithm>
+#include <cstring>
+#include "Profile.h"
+#if defined(__GNUC__) && defined(__x86_64__)
+#include <immintrin.h>
+#define ECL_SIMD_X86
+#endif
+
+enum SimdLevel {SIMD_SCALAR, SIMD_AVX2, SIMD_AVX512};
+
+// the widest level this CPU supports
+static inline SimdLevel simd_detect()
+{
+#ifdef ECL_SIMD_X86
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx512f")) return SIMD_AVX512;
+  if (__builtin_cpu_supports("avx2")) return SIMD_AVX2;
+#endif
+  return SIMD_SCALAR;
+}
+
+static inline const char* simd_name(const SimdLevel level)
+{
+  return (level == SIMD_AVX512) ? "avx512" : (level == SIMD_AVX2) ? "avx2" : "scalar";
+}
+
+// level named 'name', or -1 if there is no such level
+static inline int simd_parse(const char* const name)
+{
+  for (const SimdLevel level : {SIMD_SCALAR, SIMD_AVX2, SIMD_AVX512}) {
+    if (strcmp(name, simd_name(level)) == 0) return level;
+  }
+  return -1;
+}
+
+// root of idx with path halving; with cnt, the hops taken go into its histogram
+template <typename V>
+static inline V representative(const V idx, V* const __restrict__ nstat, CCcounters* const cnt = NULL)
+{
+  V curr = nstat[idx];
+  PROF_COUNT(long long hops = 0);
+  if (curr != idx) {
+    V next, prev = idx;
+    PROF_COUNT(hops++);
+    while (curr > (next = nstat[curr])) {
+      nstat[prev] = next;
+      prev = curr;
+      curr = next;
+      PROF_COUNT(hops++);
+    }
+  }
+  PROF_COUNT(if (cnt != NULL) count_path(cnt, hops));
+  return curr;
+}
+
+// joins the trees rooted at vstat and ostat by hooking the larger root under the smaller one; vstat follows the root
+// that a failed CAS reveals, so it stays the root of v for the following neighbors
+template <typename V>
+static inline void hook(V &vstat, V ostat, V* const __restrict__ nstat, CCcounters* const cnt = NULL)
+{
+  bool repeat;
+  do {
+    repeat = false;
+    if (vstat != ostat) {
+      V ret;
+      PROF_COUNT(if (cnt != NULL) cnt->cas++);
+      if (vstat < ostat) {
+        if ((ret = __sync_val_compare_and_swap(&nstat[ostat], ostat, vstat)) != ostat) {
+          ostat = ret;
+          repeat = true;
+        }
+      } else {
+        if ((ret = __sync_val_compare_and_swap(&nstat[vstat], vstat, ostat)) != vstat) {
+          vstat = ret;
+          repeat = true;
+        }
+      }
+      PROF_COUNT(if ((cnt != NULL) && repeat) cnt->retries++);
+    }
+  } while (repeat);
+}
+
+// Vertices with more slots than ECL_HUB_DEGREE are hubs. Instead of scanning their lists on one thread, compute cuts
+// them into chunks of ECL_HUB_CHUNK slots and spawns a task per chunk, which the idle threads of the team pick up while
+// the loop over the other vertices goes on. Every chunk finds the root of the hub itself, so the chunks need no order.
+#ifndef ECL_HUB_CHUNK
+#define ECL_HUB_CHUNK 4096
+#endif
+#ifndef ECL_HUB_DEGREE
+#define ECL_HUB_DEGREE (4 * ECL_HUB_CHUNK)
+#endif
+
+// runs hook_chunk(b, e, cnt) for the chunks of the slots beg to end - 1 as tasks; their counts go into 'total' (the
+// tasks may run on other threads, whose prof_current is not the caller's)
+template <typename E, typename F>
+static void hub_tasks(const E beg, const E end, CCcounters &total, const F hook_chunk)
+{
+  for (E b = beg; b < end; b += ECL_HUB_CHUNK) {
+    const E e = (end - b > ECL_HUB_CHUNK) ? b + ECL_HUB_CHUNK : end;
+    #pragma omp task default(none) firstprivate(b, e, hook_chunk) shared(total)
+    {
+      CCcounters cnt = {};
+      hook_chunk(b, e, &cnt);
+#if ECL_PROFILE
+      #pragma omp critical(ecl_hub_counters)
+      total += cnt;
+#endif
+    }
+  }
+}
+
+#ifdef ECL_SIMD_X86
+
+__attribute__((target("avx2")))
+static void init_avx2(const int nodes, const int* const __restrict__ nidx, const int* const __restrict__ nlist, int* const __restrict__ nstat, const int* const __restrict__ eid, const int* const __restrict__ rank, const int threshold)
+{
+  #pragma omp parallel for schedule(guided) default(none) shared(nodes, nidx, nlist, nstat, eid, rank, threshold)
+  for (int v = 0; v < nodes; v++) {
+    const __m256i vv = _mm256_set1_epi32(v);
+    const __m256i below = _mm256_set1_epi32(threshold - 1);
+    const int end = nidx[v + 1];
+    int m = v;
+    int i = nidx[v];
+    for (; i + 8 <= end; i += 8) {
+      const __m256i smaller = _mm256_cmpgt_epi32(vv, _mm256_loadu_si256((const __m256i*)&nlist[i]));
+      if (_mm256_testz_si256(smaller, smaller)) continue;
+      const __m256i r = _mm256_mask_i32gather_epi32(_mm256_setzero_si256(), rank, _mm256_loadu_si256((const __m256i*)&eid[i]), smaller, 4);
+      const unsigned mask = _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_and_si256(smaller, _mm256_cmpgt_epi32(r, below))));
+      if (mask != 0) {
+        m = nlist[i + __builtin_ctz(mask)];
+        break;
+      }
+    }
+    for (; (m == v) && (i < end); i++) {
+      if (rank[eid[i]] >= threshold) m = std::min(m, nlist[i]);
+    }
+    nstat[v] = m;
+  }
+}
+
+// hooks v, whose root vstat tracks, to its kept neighbors below v in the slots i to end - 1
+__attribute__((target("avx2")))
+static inline void hook_range_avx2(const int v, int &vstat, int i, const int end, const int* const __restrict__ nlist, int* const __restrict__ nstat, const int* const __restrict__ eid, const int* const __restrict__ rank, const int threshold, CCcounters* const cnt)
+{
+  const __m256i vv = _mm256_set1_epi32(v);
+  const __m256i below = _mm256_set1_epi32(threshold - 1);
+  for (; i + 8 <= end; i += 8) {
+    const __m256i smaller = _mm256_cmpgt_epi32(vv, _mm256_loadu_si256((const __m256i*)&nlist[i]));
+    if (_mm256_testz_si256(smaller, smaller)) continue;
+    const __m256i r = _mm256_mask_i32gather_epi32(_mm256_setzero_si256(), rank, _mm256_loadu_si256((const __m256i*)&eid[i]), smaller, 4);
+    unsigned mask = _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_and_si256(smaller, _mm256_cmpgt_epi32(r, below))));
+    while (mask != 0) {
+      hook(vstat, representative(nlist[i + __builtin_ctz(mask)], nstat, cnt), nstat, cnt);
+      mask &= mask - 1;
+    }
+  }
+  for (; i < end; i++) {
+    const int nli = nlist[i];
+    if ((v > nli) && (rank[eid[i]] >= threshold)) hook(vstat, representative(nli, nstat, cnt), nstat, cnt);
+  }
+}
+
+__attribute__((target("avx2")))
+static void compute_avx2(const int nodes, const int* const __restrict__ nidx, const int* const __restrict__ nlist, int* const __restrict__ nstat, const int* const __restrict__ eid, const int* const __restrict__ rank, const int threshold)
+{
+  CCcounters cnt = {}, hubs = {};
+  #pragma omp parallel for schedule(guided) default(none) shared(nodes, nidx, nlist, nstat, eid, rank, threshold, hubs) reduction(+: cnt)
+  for (int v = 0; v < nodes; v++) {
+    if (v != nstat[v]) {
+      const int beg = nidx[v];
+      const int end = nidx[v + 1];
+      if (end - beg > ECL_HUB_DEGREE) {
+        hub_tasks(beg, end, hubs, [=](const int b, const int e, CCcounters* const c) {
+          int vstat = representative(v, nstat, c);
+          hook_range_avx2(v, vstat, b, e, nlist, nstat, eid, rank, threshold, c);
+        });
+      } else {
+        int vstat = representative(v, nstat, &cnt);
+        hook_range_avx2(v, vstat, beg, end, nlist, nstat, eid, rank, threshold, &cnt);
+      }
+      PROF_COUNT(cnt.slots += end - beg);
+    }
+  }
+  PROF_COUNT(prof_counters(cnt));
+  PROF_COUNT(prof_counters(hubs));
+}
+
+__attribute__((target("avx512f")))
+static void init_avx512(const int nodes, const int* const __restrict__ nidx, const int* const __restrict__ nlist, int* const __restrict__ nstat, const int* const __restrict__ eid, const int* const __restrict__ rank, const int threshold)
+{
+  #pragma omp parallel for schedule(guided) default(none) shared(nodes, nidx, nlist, nstat, eid, rank, threshold)
+  for (int v = 0; v < nodes; v++) {
+    const __m512i vv = _mm512_set1_epi32(v);
+    const __m512i thr = _mm512_set1_epi32(threshold);
+    const int end = nidx[v + 1];
+    int m = v;
+    int i = nidx[v];
+    for (; i + 16 <= end; i += 16) {
+      const __mmask16 smaller = _mm512_cmplt_epi32_mask(_mm512_loadu_si512(&nlist[i]), vv);
+      if (smaller == 0) continue;
+      const __m512i r = _mm512_mask_i32gather_epi32(_mm512_setzero_si512(), smaller, _mm512_loadu_si512(&eid[i]), rank, 4);
+      const unsigned mask = _mm512_mask_cmpge_epi32_mask(smaller, r, thr);
+      if (mask != 0) {
+        m = nlist[i + __builtin_ctz(mask)];
+        break;
+      }
+    }
+    for (; (m == v) && (i < end); i++) {
+      if (rank[eid[i]] >= threshold) m = std::min(m, nlist[i]);
+    }
+    nstat[v] = m;
+  }
+}
+
+__attribute__((target("avx512f")))
+static inline void hook_range_avx512(const int v, int &vstat, int i, const int end, const int* const __restrict__ nlist, int* const __restrict__ nstat, const int* const __restrict__ eid, const int* const __restrict__ rank, const int threshold, CCcounters* const cnt)
+{
+  const __m512i vv = _mm512_set1_epi32(v);
+  const __m512i thr = _mm512_set1_epi32(threshold);
+  for (; i + 16 <= end; i += 16) {
+    const __mmask16 smaller = _mm512_cmplt_epi32_mask(_mm512_loadu_si512(&nlist[i]), vv);
+    if (smaller == 0) continue;
+    const __m512i r = _mm512_mask_i32gather_epi32(_mm512_setzero_si512(), smaller, _mm512_loadu_si512(&eid[i]), rank, 4);
+    unsigned mask = _mm512_mask_cmpge_epi32_mask(smaller, r, thr);
+    while (mask != 0) {
+      hook(vstat, representative(nlist[i + __builtin_ctz(mask)], nstat, cnt), nstat, cnt);
+      mask &= mask - 1;
+    }
+  }
+  for (; i < end; i++) {
+    const int nli = nlist[i];
+    if ((v > nli) && (rank[eid[i]] >= threshold)) hook(vstat, representative(nli, nstat, cnt), nstat, cnt);
+  }
+}
+
+__attribute__((target("avx512f")))
+static void compute_avx512(const int nodes, const int* const __restrict__ nidx, const int* const __restrict__ nlist, int* const __restrict__ nstat, const int* const __restrict__ eid, const int* const __restrict__ rank, const int threshold)
+{
+  CCcounters cnt = {}, hubs = {};
+  #pragma omp parallel for schedule(guided) default(none) shared(nodes, nidx, nlist, nstat, eid, rank, threshold, hubs) reduction(+: cnt)
+  for (int v = 0; v < nodes; v++) {
+    if (v != nstat[v]) {
+      const int beg = nidx[v];
+      const int end = nidx[v + 1];
+      if (end - beg > ECL_HUB_DEGREE) {
+        hub_tasks(beg, end, hubs, [=](const int b, const int e, CCcounters* const c) {
+          int vstat = representative(v, nstat, c);
+          hook_range_avx512(v, vstat, b, e, nlist, nstat, eid, rank, threshold, c);
+        });
+      } else {
+        int vstat = representative(v, nstat, &cnt);
+        hook_range_avx512(v, vstat, beg, end, nlist, nstat, eid, rank, threshold, &cnt);
+      }
+      PROF_COUNT(cnt.slots += end - beg);
+    }
+  }
+  PROF_COUNT(prof_counters(cnt));
+  PROF_COUNT(prof_counters(hubs));
+}
+
+#endif
+
+// init and compute on the vector unit of the given level; false if there is none, in which case the caller runs its
+// scalar loop
+static inline bool simd_init(const SimdLevel level, const int nodes, const int* const nidx, const int* const nlist, int* const nstat, const int* const eid, const int* const rank, const int threshold)
+{
+#ifdef ECL_SIMD_X86
+  if (level == SIMD_AVX512) {init_avx512(nodes, nidx, nlist, nstat, eid, rank, threshold);  return true;}
+  if (level == SIMD_AVX2) {init_avx2(nodes, nidx, nlist, nstat, eid, rank, threshold);  return true;}
+#endif
+  return false;
+}
+
+static inline bool simd_compute(const SimdLevel level, const int nodes, const int* const nidx, const int* const nlist, int* const nstat, const int* const eid, const int* const rank, const int threshold)
+{
+#ifdef ECL_SIMD_X86
+  if (level == SIMD_AVX512) {compute_avx512(nodes, nidx, nlist, nstat, eid, rank, threshold);  return true;}
+  if (level == SIMD_AVX2) {compute_avx2(nodes, nidx, nlist, nstat, eid, rank, threshold);  return true;}
+#endif
+  return false;
+}
+
+#endif
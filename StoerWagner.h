@@ -0,0 +1,311 @@
+/*
+Exact minimum cut (Stoer and Wagner, 1997) directly on the CSR arrays of an
+ECLgraph, without building an adjacency-list copy, and the Nagamochi-Ibaraki
+sparse certificate, which uses the same maximum-adjacency scan.
+
+Every super vertex keeps the list of its original members and every original
+vertex the id of its super vertex (on a merge, the smaller list is relabeled),
+so a phase scans each original CSR slot once and maps the far endpoint to its
+super vertex with a single lookup. The maximum-adjacency order comes from a
+bucket queue when the total edge weight W is small enough (O(1) key
+increases, O(m + W) per phase) and from an indexed 4-ary max-heap otherwise
+(O(m log n) per phase). There are n - 1 phases. Edge weights (1 if eweight
+is NULL) must be non-negative; parallel CSR entries count separately, as in
+boost::stoer_wagner_min_cut.
+*/
+
+
+#ifndef ECL_STOER_WAGNER
+#define ECL_STOER_WAGNER
+
+#include <algorithm>
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+#include "ECLgraph.h"
+
+// indexed 4-ary max-heap over the super vertices of a phase
+template <typename vidx_t>
+struct SWheap {
+  std::vector<long long> key;
+  std::vector<vidx_t> heap;
+  std::vector<vidx_t> pos;  // index in the heap, -1 if not in it
+
+  explicit SWheap(const vidx_t n) : key(n, 0), pos(n, -1) {heap.reserve(n);}
+
+  void reset(const std::vector<vidx_t> &active)
+  {
+    heap.clear();
+    for (const vidx_t r : active) {
+      key[r] = 0;
+      pos[r] = (vidx_t)heap.size();
+      heap.push_back(r);
+    }
+  }
+
+  bool empty() const {return heap.empty();}
+  bool contains(const vidx_t v) const {return pos[v] >= 0;}
+
+  void place(const vidx_t k, const vidx_t v)
+  {
+    heap[k] = v;
+    pos[v] = k;
+  }
+
+  void increase(const vidx_t v, const long long w)
+  {
+    key[v] += w;
+    vidx_t k = pos[v];
+    while (k > 0) {
+      const vidx_t p = (k - 1) / 4;
+      if (key[heap[p]] >= key[v]) break;
+      place(k, heap[p]);
+      k = p;
+    }
+    place(k, v);
+  }
+
+  vidx_t pop()
+  {
+    const vidx_t top = heap[0];
+    const vidx_t v = heap.back();
+    heap.pop_back();
+    const vidx_t size = (vidx_t)heap.size();
+    if (size > 0) {
+      vidx_t k = 0;
+      while (true) {
+        vidx_t c = 4 * k + 1;
+        if (c >= size) break;
+        const vidx_t end = std::min(c + 4, size);
+        for (vidx_t j = c + 1; j < end; j++) {
+          if (key[heap[j]] > key[heap[c]]) c = j;
+        }
+        if (key[heap[c]] <= key[v]) break;
+        place(k, heap[c]);
+        k = c;
+      }
+      place(k, v);
+    }
+    pos[top] = -1;
+    return top;
+  }
+};
+
+// bucket queue for integer keys up to 'max': doubly-linked buckets, pops scan down from the highest non-empty one
+template <typename vidx_t>
+struct SWbuckets {
+  std::vector<long long> key;
+  std::vector<vidx_t> head;
+  std::vector<vidx_t> next;
+  std::vector<vidx_t> prev;
+  std::vector<char> in;
+  long long top;
+  vidx_t size;
+
+  SWbuckets(const vidx_t n, const long long max) : key(n, 0), head(max + 1, -1), next(n), prev(n), in(n, 0), top(0), size(0) {}
+
+  void link(const vidx_t v)
+  {
+    const long long k = key[v];
+    prev[v] = -1;
+    next[v] = head[k];
+    if (head[k] >= 0) prev[head[k]] = v;
+    head[k] = v;
+  }
+
+  void unlink(const vidx_t v)
+  {
+    if (prev[v] >= 0) next[prev[v]] = next[v]; else head[key[v]] = next[v];
+    if (next[v] >= 0) prev[next[v]] = prev[v];
+  }
+
+  void reset(const std::vector<vidx_t> &active)
+  {
+    for (const vidx_t r : active) {
+      key[r] = 0;
+      in[r] = 1;
+      link(r);
+    }
+    top = 0;
+    size = (vidx_t)active.size();
+  }
+
+  bool empty() const {return size == 0;}
+  bool contains(const vidx_t v) const {return in[v];}
+
+  void increase(const vidx_t v, const long long w)
+  {
+    unlink(v);
+    key[v] += w;
+    link(v);
+    top = std::max(top, key[v]);
+  }
+
+  vidx_t pop()
+  {
+    while (head[top] < 0) top--;
+    const vidx_t v = head[top];
+    unlink(v);
+    in[v] = 0;
+    size--;
+    return v;
+  }
+};
+
+template <typename vidx_t, typename eidx_t, typename queue_t>
+static long long stoer_wagner_phases(const ECLgraphT<vidx_t, eidx_t> &g, queue_t &q, std::vector<char>* const side)
+{
+  const vidx_t n = g.nodes;
+  std::vector<vidx_t> rep(n), next(n, -1), last(n), size(n, 1), active(n);
+  for (vidx_t v = 0; v < n; v++) {
+    rep[v] = v;
+    last[v] = v;
+    active[v] = v;
+  }
+
+  long long best = LLONG_MAX;
+  while (active.size() > 1) {
+    // maximum-adjacency order over the current super vertices
+    q.reset(active);
+    vidx_t s = -1, t = -1;
+    long long cut = 0;
+    while (!q.empty()) {
+      s = t;
+      t = q.pop();
+      cut = q.key[t];
+      for (vidx_t v = t; v != -1; v = next[v]) {
+        for (eidx_t i = g.nindex[v]; i < g.nindex[v + 1]; i++) {
+          const vidx_t r = rep[g.nlist[i]];
+          if (q.contains(r)) q.increase(r, (g.eweight != NULL) ? g.eweight[i] : 1);
+        }
+      }
+    }
+
+    // the cut of the phase separates the last super vertex from the rest
+    if (cut < best) {
+      best = cut;
+      if (side != NULL) {
+        side->assign(n, 0);
+        for (vidx_t v = t; v != -1; v = next[v]) (*side)[v] = 1;
+      }
+    }
+
+    // merge the last two super vertices, relabeling the smaller member list (O(n log n) relabels in total)
+    if (size[s] < size[t]) std::swap(s, t);
+    for (vidx_t v = t; v != -1; v = next[v]) rep[v] = s;
+    next[last[s]] = t;
+    last[s] = last[t];
+    size[s] += size[t];
+    active.erase(std::find(active.begin(), active.end(), t));
+  }
+  return best;
+}
+
+// bucket queue if the total weight stays in proportion to the graph, heap otherwise (see the comment at the top)
+template <typename vidx_t, typename eidx_t>
+static long long total_weight(const ECLgraphT<vidx_t, eidx_t> &g)
+{
+  long long total = 0;
+  for (eidx_t i = 0; i < g.nindex[g.nodes]; i++) {
+    const int w = (g.eweight != NULL) ? g.eweight[i] : 1;
+    if (w < 0) {fprintf(stderr, "ERROR: found negative edge weight\n\n");  exit(-1);}
+    total += w;
+  }
+  return total;
+}
+
+template <typename vidx_t, typename eidx_t>
+static bool use_buckets(const ECLgraphT<vidx_t, eidx_t> &g, const long long total)
+{
+  return total <= 4LL * (g.nodes + g.nindex[g.nodes]);
+}
+
+// returns the weight of a minimum cut; if side is given, it is set to 1 for the vertices on one side of that cut
+template <typename vidx_t, typename eidx_t>
+long long stoer_wagner(const ECLgraphT<vidx_t, eidx_t> &g, std::vector<char>* const side = NULL)
+{
+  const vidx_t n = g.nodes;
+  if (n < 2) {fprintf(stderr, "ERROR: a minimum cut needs at least two nodes\n\n");  exit(-1);}
+  const long long total = total_weight(g);
+  if (use_buckets(g, total)) {
+    SWbuckets<vidx_t> q(n, total);
+    return stoer_wagner_phases(g, q, side);
+  }
+  SWheap<vidx_t> q(n);
+  return stoer_wagner_phases(g, q, side);
+}
+
+// One maximum-adjacency scan (Nagamochi and Ibaraki, 1992): when x is scanned, edge (x, y) to an unscanned y
+// takes the forest indices r(y) + 1 .. r(y) + w, where r(y) is the weight already attached to y. Only the part with
+// indices up to k is kept, which leaves at most k * (n - 1) edge weight and keeps every cut of value up to k
+// (larger cuts keep at least k). Parallel CSR entries are separate edges, as in the phases above.
+template <typename vidx_t, typename eidx_t, typename queue_t>
+static void certificate_scan(const ECLgraphT<vidx_t, eidx_t> &g, const long long k, queue_t &q, std::vector<vidx_t> &src, std::vector<vidx_t> &dst, std::vector<int> &wgt)
+{
+  const vidx_t n = g.nodes;
+  std::vector<vidx_t> all(n);
+  for (vidx_t v = 0; v < n; v++) all[v] = v;
+  q.reset(all);
+  while (!q.empty()) {
+    const vidx_t x = q.pop();
+    for (eidx_t i = g.nindex[x]; i < g.nindex[x + 1]; i++) {
+      const vidx_t y = g.nlist[i];
+      if (!q.contains(y)) continue;
+      const int w = (g.eweight != NULL) ? g.eweight[i] : 1;
+      const long long keep = std::min((long long)w, std::max(0LL, k - q.key[y]));
+      if (keep > 0) {
+        src.push_back(x);
+        dst.push_back(y);
+        wgt.push_back((int)keep);
+      }
+      q.increase(y, w);
+    }
+  }
+}
+
+// sparse graph with the same minimum cut as g if that cut is at most k (e.g., the minimum weighted degree)
+template <typename vidx_t, typename eidx_t>
+ECLgraphT<vidx_t, eidx_t> sparse_certificate(const ECLgraphT<vidx_t, eidx_t> &g, const long long k)
+{
+  const vidx_t n = g.nodes;
+  std::vector<vidx_t> src, dst;
+  std::vector<int> wgt;
+  const long long total = total_weight(g);
+  if (use_buckets(g, total)) {
+    SWbuckets<vidx_t> q(n, total);
+    certificate_scan(g, k, q, src, dst, wgt);
+  } else {
+    SWheap<vidx_t> q(n);
+    certificate_scan(g, k, q, src, dst, wgt);
+  }
+
+  ECLgraphT<vidx_t, eidx_t> h;
+  h.nodes = n;
+  h.edges = 2 * (eidx_t)src.size();
+  h.nindex = (eidx_t*)calloc(n + 1, sizeof(h.nindex[0]));
+  h.nlist = (vidx_t*)malloc(h.edges * sizeof(h.nlist[0]) + 1);
+  h.eweight = (g.eweight != NULL) ? (int*)malloc(h.edges * sizeof(h.eweight[0]) + 1) : NULL;
+  if ((h.nindex == NULL) || (h.nlist == NULL) || ((g.eweight != NULL) && (h.eweight == NULL))) {fprintf(stderr, "ERROR: memory allocation failed\n\n");  exit(-1);}
+  for (std::size_t e = 0; e < src.size(); e++) {
+    h.nindex[src[e] + 1]++;
+    h.nindex[dst[e] + 1]++;
+  }
+  for (vidx_t v = 0; v < n; v++) {
+    h.nindex[v + 1] += h.nindex[v];
+  }
+  std::vector<eidx_t> pos(h.nindex, h.nindex + n);
+  for (std::size_t e = 0; e < src.size(); e++) {
+    const eidx_t a = pos[src[e]]++;
+    const eidx_t b = pos[dst[e]]++;
+    h.nlist[a] = dst[e];
+    h.nlist[b] = src[e];
+    if (h.eweight != NULL) {
+      h.eweight[a] = wgt[e];
+      h.eweight[b] = wgt[e];
+    }
+  }
+  return h;
+}
+
+#endif
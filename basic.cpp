@@ -1,5 +1,15 @@
 // system headers
+#include <algorithm>
+#include <climits>
+#include <cstring>
 #include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+#include <unistd.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 // Custom headers
 #include "ECLgraph.h"
@@ -56,12 +66,482 @@ void runBasic(const char* output_file) {
     freeECLgraph(g);
 }
 
+/*
+ * Synthetic families for tests at scale. Every vertex's neighbor list is a
+ * function of the vertex and the seed (counter-based hashing, no shared RNG
+ * state), so blocks of vertices are generated in parallel and streamed to
+ * disk through ECLwriterT in vertex order; memory stays at O(nodes + block).
+ *
+ *   complete  K_n                                     min cut n - 1
+ *   grid      rows x cols mesh                        min cut 2 (1 for a path)
+ *   torus     rows x cols wrap-around mesh            min cut 4
+ *   cycles    union of d/2 random Hamiltonian cycles  degree and min cut <= d (shared edges merged)
+ *   rmat      R-MAT (0.57, 0.19, 0.19, 0.05) with n*d/2 draws plus a ring for connectivity
+ *   planted   two halves that are d-edge-connected circulants, joined by k random edges: min cut k (needs k < d)
+ *
+ * cycles, rmat, and planted relabel vertices with a random permutation.
+ */
+enum Family {BASIC, COMPLETE, GRID, TORUS, CYCLES, RMAT, PLANTED};
+
+struct GenParams {
+    Family family;
+    long long nodes;
+    long long rows;
+    long long cols;
+    long long degree;
+    long long cut;
+    unsigned long long seed;
+    long long block;
+};
+
+static inline unsigned long long mix(unsigned long long x) {
+    x += 0x9e3779b97f4a7c15ULL;
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+    return x ^ (x >> 31);
+}
+
+/*
+ * Random permutation of [0, n) without storage: a 4-round Feistel network on
+ * the smallest even number of bits that covers n, with cycle walking to stay
+ * inside the range.
+ */
+struct Permutation {
+    unsigned long long n;
+    int half;
+    unsigned long long mask;
+    unsigned long long key[4];
+
+    Permutation(const unsigned long long n, const unsigned long long seed) : n(n) {
+        int bits = 2;
+        while ((1ULL << bits) < n) bits += 2;
+        half = bits / 2;
+        mask = (1ULL << half) - 1;
+        for (int r = 0; r < 4; r++) key[r] = mix(seed * 4 + r);
+    }
+
+    unsigned long long round(const unsigned long long x, const int r) const {
+        return mix(x ^ key[r]) & mask;
+    }
+
+    unsigned long long forward(unsigned long long x) const {
+        do {
+            unsigned long long l = x >> half, r = x & mask;
+            for (int k = 0; k < 4; k++) {
+                const unsigned long long t = l ^ round(r, k);
+                l = r;
+                r = t;
+            }
+            x = (l << half) | r;
+        } while (x >= n);
+        return x;
+    }
+
+    unsigned long long inverse(unsigned long long x) const {
+        do {
+            unsigned long long l = x >> half, r = x & mask;
+            for (int k = 3; k >= 0; k--) {
+                const unsigned long long t = r ^ round(l, k);
+                r = l;
+                l = t;
+            }
+            x = (l << half) | r;
+        } while (x >= n);
+        return x;
+    }
+};
+
+struct Generator {
+    GenParams p;
+    std::vector<Permutation> perms;
+    long long n1;
+    std::vector< std::pair<long long, long long> > cross_a;  // planted crossing edges sorted by first endpoint
+    std::vector< std::pair<long long, long long> > cross_b;  // the same edges reversed, sorted by first endpoint
+
+    explicit Generator(const GenParams &p) : p(p), n1(p.nodes / 2) {
+        if (p.family == CYCLES) {
+            for (long long k = 0; k < p.degree / 2; k++) perms.emplace_back(p.nodes, p.seed + k);
+        } else if ((p.family == RMAT) || (p.family == PLANTED)) {
+            perms.emplace_back(p.nodes, p.seed);
+        }
+        if (p.family == PLANTED) {
+            unsigned long long ctr = mix(p.seed ^ 0x706c616e746564ULL);
+            while ((long long)cross_a.size() < p.cut) {
+                const long long a = mix(ctr++) % n1;
+                const long long b = n1 + mix(ctr++) % (p.nodes - n1);
+                cross_a.emplace_back(a, b);
+                std::sort(cross_a.begin(), cross_a.end());
+                cross_a.erase(std::unique(cross_a.begin(), cross_a.end()), cross_a.end());
+            }
+            for (const auto &[a, b] : cross_a) cross_b.emplace_back(b, a);
+            std::sort(cross_b.begin(), cross_b.end());
+        }
+    }
+
+    // upper bound on the number of CSR slots (both directions)
+    long long slots() const {
+        switch (p.family) {
+            case COMPLETE: return p.nodes * (p.nodes - 1);
+            case GRID:
+            case TORUS: return 4 * p.nodes;
+            case CYCLES: return p.nodes * p.degree;
+            case RMAT: return p.nodes * p.degree + 2 * p.nodes;
+            case PLANTED: return p.nodes * p.degree + 2 * p.cut;
+            default: return 0;
+        }
+    }
+
+    // largest degree of a vertex, used to size the blocks
+    long long maxdegree() const {
+        switch (p.family) {
+            case COMPLETE: return p.nodes - 1;
+            case GRID:
+            case TORUS: return 4;
+            case CYCLES: return p.degree;
+            case PLANTED: return p.degree + p.cut;
+            default: return p.nodes;
+        }
+    }
+
+    long long mincut() const {
+        switch (p.family) {
+            case COMPLETE: return p.nodes - 1;
+            case GRID: return ((p.rows == 1) || (p.cols == 1)) ? 1 : 2;
+            case TORUS: return 4;
+            case PLANTED: return p.cut;
+            default: return -1;
+        }
+    }
+
+    // sorted, duplicate-free neighbors of v (all families except rmat)
+    void neighbors(const long long v, std::vector<long long> &out) const {
+        out.clear();
+        switch (p.family) {
+            case COMPLETE:
+                for (long long u = 0; u < p.nodes; u++) {
+                    if (u != v) out.push_back(u);
+                }
+                break;
+            case GRID:
+            case TORUS: {
+                const long long r = v / p.cols, c = v % p.cols;
+                const bool wrap = (p.family == TORUS);
+                if ((r > 0) || wrap) out.push_back(((r + p.rows - 1) % p.rows) * p.cols + c);
+                if ((r < p.rows - 1) || wrap) out.push_back(((r + 1) % p.rows) * p.cols + c);
+                if ((c > 0) || wrap) out.push_back(r * p.cols + (c + p.cols - 1) % p.cols);
+                if ((c < p.cols - 1) || wrap) out.push_back(r * p.cols + (c + 1) % p.cols);
+                break;
+            }
+            case CYCLES:
+                for (const Permutation &pi : perms) {
+                    const long long pos = pi.inverse(v);
+                    out.push_back(pi.forward((pos + 1) % p.nodes));
+                    out.push_back(pi.forward((pos + p.nodes - 1) % p.nodes));
+                }
+                break;
+            case PLANTED: {
+                const Permutation &pi = perms[0];
+                const long long old = pi.inverse(v);
+                const long long base = (old < n1) ? 0 : n1;
+                const long long size = (old < n1) ? n1 : p.nodes - n1;
+                const long long local = old - base;
+                for (long long j = 1; j <= p.degree / 2; j++) {
+                    out.push_back(pi.forward(base + (local + j) % size));
+                    out.push_back(pi.forward(base + (local + size - j) % size));
+                }
+                const auto &cross = (old < n1) ? cross_a : cross_b;
+                auto it = std::lower_bound(cross.begin(), cross.end(), std::make_pair(old, -1LL));
+                for (; (it != cross.end()) && (it->first == old); it++) out.push_back(pi.forward(it->second));
+                break;
+            }
+            default:
+                break;
+        }
+        std::sort(out.begin(), out.end());
+        out.erase(std::unique(out.begin(), out.end()), out.end());
+    }
+
+    // endpoints of R-MAT draw i (the draws past n*d/2 form a ring through all vertices)
+    std::pair<long long, long long> rmat_edge(const long long i) const {
+        const long long draws = p.nodes * p.degree / 2;
+        if (i >= draws) {
+            const long long v = i - draws;
+            return std::make_pair(v, (v + 1) % p.nodes);
+        }
+        int scale = 0;
+        while ((1LL << scale) < p.nodes) scale++;
+        // a draw that falls outside [0, n) when n is not a power of two is redrawn with the next attempt number, which
+        // is mixed in on its own so that no attempt can run into the stream of another level or draw
+        unsigned long long s, d;
+        long long attempt = 0;
+        do {
+            s = 0;
+            d = 0;
+            for (int level = 0; level < scale; level++) {
+                const double r = (mix(mix(p.seed ^ mix(i * 64 + level)) ^ mix(~attempt)) >> 11) * (1.0 / 9007199254740992.0);
+                s <<= 1;
+                d <<= 1;
+                if (r >= 0.57 + 0.19 + 0.19) {s |= 1; d |= 1;}
+                else if (r >= 0.57 + 0.19) {s |= 1;}
+                else if (r >= 0.57) {d |= 1;}
+            }
+            attempt++;
+        } while ((s >= (unsigned long long)p.nodes) || (d >= (unsigned long long)p.nodes));
+        return std::make_pair(perms[0].forward(s), perms[0].forward(d));
+    }
+
+    long long rmat_draws() const {
+        return p.nodes * p.degree / 2 + ((p.nodes > 2) ? p.nodes : 0);
+    }
+};
+
+// neighbor lists of the vertices in [lo, hi): degrees first, then the lists in parallel
+template <typename E>
+static void generate_block(const Generator &gen, const long long lo, const long long hi, std::vector<E> &degree, std::vector<int> &nlist)
+{
+    const long long count = hi - lo;
+    degree.assign(count, 0);
+    std::vector<long long> offset(count + 1, 0);
+    #pragma omp parallel default(none) shared(gen, lo, count, degree, offset)
+    {
+        std::vector<long long> nbrs;
+        #pragma omp for schedule(dynamic, 256)
+        for (long long k = 0; k < count; k++) {
+            gen.neighbors(lo + k, nbrs);
+            degree[k] = (E)nbrs.size();
+        }
+    }
+    for (long long k = 0; k < count; k++) offset[k + 1] = offset[k] + degree[k];
+    nlist.resize(offset[count]);
+    #pragma omp parallel default(none) shared(gen, lo, count, offset, nlist)
+    {
+        std::vector<long long> nbrs;
+        #pragma omp for schedule(dynamic, 256)
+        for (long long k = 0; k < count; k++) {
+            gen.neighbors(lo + k, nbrs);
+            std::copy(nbrs.begin(), nbrs.end(), nlist.begin() + offset[k]);
+        }
+    }
+}
+
+// R-MAT blocks: runs of consecutive vertices whose draw counts add up to at most 'block' slots (at least one vertex
+// each); returns the first vertex of every block followed by the node count
+static std::vector<long long> rmat_blocks(const std::vector<unsigned> &raw, const long long block)
+{
+    const long long nodes = raw.size();
+    std::vector<long long> start(1, 0);
+    long long hi = 0;
+    while (hi < nodes) {
+        long long sum = 0;
+        do {
+            sum += raw[hi++];
+        } while ((hi < nodes) && (sum + raw[hi] <= block));
+        start.push_back(hi);
+    }
+    return start;
+}
+
+struct RmatSlot {
+    int v;
+    int u;
+};
+
+// all R-MAT slots in one pass over the draws: each slot (v, u) is staged for the block of v and appended to that
+// block's region of a temporary file, so that the draws are generated once rather than once per block while memory
+// stays near one block; base receives the first slot of every region
+static FILE* rmat_spill(const Generator &gen, const std::vector<unsigned> &raw, const std::vector<long long> &start, const long long block, std::vector<long long> &base)
+{
+    const int blocks = start.size() - 1;
+    base.assign(blocks + 1, 0);
+    for (int b = 0; b < blocks; b++) {
+        base[b + 1] = base[b];
+        for (long long v = start[b]; v < start[b + 1]; v++) base[b + 1] += raw[v];
+    }
+    FILE* const f = tmpfile();  if (f == NULL) {fprintf(stderr, "ERROR: could not create temporary file\n\n");  exit(-1);}
+
+    const std::size_t cap = std::max(1024LL, block / blocks);
+    std::vector< std::vector<RmatSlot> > stage(blocks);
+    std::vector<long long> fill(base.begin(), base.end() - 1);
+    const auto flush = [&](const int b) {
+        if (fseeko(f, fill[b] * (long long)sizeof(RmatSlot), SEEK_SET) != 0) {fprintf(stderr, "ERROR: failed to seek in temporary file\n\n");  exit(-1);}
+        const std::size_t cnt = fwrite(stage[b].data(), sizeof(RmatSlot), stage[b].size(), f);  if (cnt != stage[b].size()) {fprintf(stderr, "ERROR: failed to write temporary file\n\n");  exit(-1);}
+        fill[b] += cnt;
+        stage[b].clear();
+    };
+    const auto put = [&](const long long v, const long long u) {
+        const int b = std::upper_bound(start.begin(), start.end(), v) - start.begin() - 1;
+        stage[b].push_back(RmatSlot{(int)v, (int)u});
+        if (stage[b].size() >= cap) flush(b);
+    };
+
+    // the draws are generated in parallel a chunk at a time and staged in draw order
+    const long long draws = gen.rmat_draws();
+    const long long chunk = 1 << 20;
+    std::vector< std::pair<long long, long long> > edges(std::min(chunk, draws));
+    for (long long beg = 0; beg < draws; beg += chunk) {
+        const long long num = std::min(chunk, draws - beg);
+        #pragma omp parallel for schedule(static, 4096) default(none) shared(gen, beg, num, edges)
+        for (long long i = 0; i < num; i++) {
+            edges[i] = gen.rmat_edge(beg + i);
+        }
+        for (long long i = 0; i < num; i++) {
+            if (edges[i].first != edges[i].second) {
+                put(edges[i].first, edges[i].second);
+                put(edges[i].second, edges[i].first);
+            }
+        }
+    }
+    for (int b = 0; b < blocks; b++) flush(b);
+    return f;
+}
+
+// R-MAT lists of [lo, hi), each sorted and deduplicated; 'raw' holds the per-vertex draw counts of the whole graph.
+// The slots are read from the block's region (starting at slot 'base') of the spill file, or, for a graph that is a
+// single block, taken straight from the draws
+template <typename E>
+static void generate_rmat_block(const Generator &gen, const std::vector<unsigned> &raw, const long long lo, const long long hi, FILE* const spill, const long long base, std::vector<E> &degree, std::vector<int> &nlist)
+{
+    const long long count = hi - lo;
+    std::vector<long long> offset(count + 1, 0);
+    for (long long k = 0; k < count; k++) offset[k + 1] = offset[k] + raw[lo + k];
+    std::vector<long long> pos(offset.begin(), offset.end() - 1);
+    std::vector<int> buf(offset[count]);
+    if (spill != NULL) {
+        std::vector<RmatSlot> slots(offset[count]);
+        if (fseeko(spill, base * (long long)sizeof(RmatSlot), SEEK_SET) != 0) {fprintf(stderr, "ERROR: failed to seek in temporary file\n\n");  exit(-1);}
+        const std::size_t cnt = fread(slots.data(), sizeof(RmatSlot), slots.size(), spill);  if (cnt != slots.size()) {fprintf(stderr, "ERROR: failed to read temporary file\n\n");  exit(-1);}
+        for (const RmatSlot &s : slots) buf[pos[s.v - lo]++] = s.u;
+    } else {
+        const long long draws = gen.rmat_draws();
+        #pragma omp parallel for schedule(static, 4096) default(none) shared(gen, lo, hi, draws, pos, buf)
+        for (long long i = 0; i < draws; i++) {
+            const std::pair<long long, long long> e = gen.rmat_edge(i);
+            if (e.first == e.second) continue;
+            if ((e.first >= lo) && (e.first < hi)) buf[__sync_fetch_and_add(&pos[e.first - lo], 1LL)] = (int)e.second;
+            if ((e.second >= lo) && (e.second < hi)) buf[__sync_fetch_and_add(&pos[e.second - lo], 1LL)] = (int)e.first;
+        }
+    }
+
+    degree.assign(count, 0);
+    #pragma omp parallel for schedule(dynamic, 256) default(none) shared(count, offset, pos, buf, degree)
+    for (long long k = 0; k < count; k++) {
+        std::sort(buf.begin() + offset[k], buf.begin() + pos[k]);
+        degree[k] = (E)(std::unique(buf.begin() + offset[k], buf.begin() + pos[k]) - (buf.begin() + offset[k]));
+    }
+    nlist.clear();
+    for (long long k = 0; k < count; k++) {
+        nlist.insert(nlist.end(), buf.begin() + offset[k], buf.begin() + offset[k] + degree[k]);
+    }
+}
+
+template <typename E>
+static void runGenerator(const GenParams &p, const char* output_file)
+{
+    const Generator gen(p);
+    ECLwriterT<int, E> w = openECLwriter<int, E>(output_file, (int)p.nodes);
+
+    // R-MAT needs the number of draws that land on each vertex to size its blocks; with more than one block, the slots
+    // are bucketed by block in a spill file
+    std::vector<unsigned> raw;
+    std::vector<long long> start, base;
+    FILE* spill = NULL;
+    if (p.family == RMAT) {
+        raw.assign(p.nodes, 0);
+        const long long draws = gen.rmat_draws();
+        #pragma omp parallel for schedule(static, 4096) default(none) shared(gen, draws, raw)
+        for (long long i = 0; i < draws; i++) {
+            const std::pair<long long, long long> e = gen.rmat_edge(i);
+            if (e.first != e.second) {
+                __sync_fetch_and_add(&raw[e.first], 1U);
+                __sync_fetch_and_add(&raw[e.second], 1U);
+            }
+        }
+        start = rmat_blocks(raw, p.block);
+        if (start.size() > 2) spill = rmat_spill(gen, raw, start, p.block, base);
+    }
+
+    std::vector<E> degree;
+    std::vector<int> nlist;
+    long long lo = 0;
+    for (int b = 0; lo < p.nodes; b++) {
+        long long hi;
+        if (p.family == RMAT) {
+            hi = start[b + 1];
+            generate_rmat_block(gen, raw, lo, hi, spill, (spill != NULL) ? base[b] : 0, degree, nlist);
+        } else {
+            hi = std::min(p.nodes, lo + std::max(1LL, p.block / std::max(1LL, gen.maxdegree())));
+            generate_block(gen, lo, hi, degree, nlist);
+        }
+        appendECLwriter(w, nlist.data(), degree.data(), (int)(hi - lo));
+        lo = hi;
+    }
+    const long long edges = closeECLwriter(w);
+    if (spill != NULL) fclose(spill);
+
+    std::cout << "nodes: " << p.nodes << std::endl;
+    std::cout << "edges: " << edges << " (" << edges / 2 << " undirected)" << std::endl;
+    if (gen.mincut() >= 0) {
+        std::cout << "minimum cut: " << gen.mincut() << std::endl;
+    }
+}
+
+// GraphTest includes this file with ECL_NO_MAIN defined to check the generators
+#ifndef ECL_NO_MAIN
 int main(const int argc, char* argv[]) {
     std::cout << "Create Basic Graph v0.1" << std::endl;
 
-    if (argc != 2) {fprintf(stderr, "USAGE: %s output_file_name\n\n", argv[0]);  exit(-1);}
+    const char* usage = "USAGE: %s [-f basic|complete|grid|torus|cycles|rmat|planted] [-n nodes] [-r rows] [-c cols] [-d degree] [-k planted_cut] [-s seed] [-b block_slots] output_file_name\n\n";
+    GenParams p{BASIC, 0, 0, 0, 8, 1, 1, 1LL << 26};
+    int opt;
+    while ((opt = getopt(argc, argv, "f:n:r:c:d:k:s:b:")) != -1) {
+        switch (opt) {
+            case 'f':
+                if (strcmp(optarg, "basic") == 0) p.family = BASIC;
+                else if (strcmp(optarg, "complete") == 0) p.family = COMPLETE;
+                else if (strcmp(optarg, "grid") == 0) p.family = GRID;
+                else if (strcmp(optarg, "torus") == 0) p.family = TORUS;
+                else if (strcmp(optarg, "cycles") == 0) p.family = CYCLES;
+                else if (strcmp(optarg, "rmat") == 0) p.family = RMAT;
+                else if (strcmp(optarg, "planted") == 0) p.family = PLANTED;
+                else {fprintf(stderr, "ERROR: unknown graph family %s\n\n", optarg);  exit(-1);}
+                break;
+            case 'n': p.nodes = atoll(optarg); break;
+            case 'r': p.rows = atoll(optarg); break;
+            case 'c': p.cols = atoll(optarg); break;
+            case 'd': p.degree = atoll(optarg); break;
+            case 'k': p.cut = atoll(optarg); break;
+            case 's': p.seed = strtoull(optarg, NULL, 10); break;
+            case 'b': p.block = atoll(optarg); break;
+            default: fprintf(stderr, usage, argv[0]);  exit(-1);
+        }
+    }
+    if (argc - optind != 1) {fprintf(stderr, usage, argv[0]);  exit(-1);}
+    const char* output_file = argv[optind];
+
+    if (p.family == BASIC) {
+        runBasic(output_file);
+        return 0;
+    }
+
+    if ((p.family == GRID) || (p.family == TORUS)) p.nodes = p.rows * p.cols;
+    if ((p.family == TORUS) && ((p.rows < 3) || (p.cols < 3))) {fprintf(stderr, "ERROR: a torus needs at least 3 rows and 3 columns\n\n");  exit(-1);}
+    if ((p.nodes < 2) || (p.nodes >= INT_MAX)) {fprintf(stderr, "ERROR: node count must be between 2 and %d\n\n", INT_MAX - 1);  exit(-1);}
+    if (((p.family == CYCLES) || (p.family == PLANTED)) && ((p.degree < 2) || (p.degree % 2 != 0))) {fprintf(stderr, "ERROR: degree must be even and positive\n\n");  exit(-1);}
+    if ((p.family == CYCLES) && (p.nodes <= p.degree)) {fprintf(stderr, "ERROR: degree must be below the node count\n\n");  exit(-1);}
+    if ((p.family == RMAT) && (p.degree < 1)) {fprintf(stderr, "ERROR: degree must be positive\n\n");  exit(-1);}
+    if (p.family == PLANTED) {
+        if (p.nodes / 2 <= p.degree) {fprintf(stderr, "ERROR: each half needs more than 'degree' nodes\n\n");  exit(-1);}
+        if ((p.cut < 1) || (p.cut >= p.degree)) {fprintf(stderr, "ERROR: planted cut must be between 1 and degree - 1\n\n");  exit(-1);}
+    }
+    if (p.block < 1) {fprintf(stderr, "ERROR: block size must be positive\n\n");  exit(-1);}
 
-    runBasic(argv[1]);
+    // the compact layout when every offset fits, 64-bit edge offsets otherwise
+    if (Generator(p).slots() <= INT_MAX) {
+        runGenerator<int>(p, output_file);
+    } else {
+        runGenerator<long long>(p, output_file);
+    }
 
     return 0;
-}
\ No newline at end of file
+}
+#endif
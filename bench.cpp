@@ -0,0 +1,295 @@
+/*
+Benchmark driver for the min-cut codes in this directory.
+
+For every input graph and thread count it runs the Karger binary, the plain
+ECL-CC pass of Karger-orig, and, once since they are serial, both
+boost::stoer_wagner_min_cut and the CSR Stoer-Wagner engine (Karger -e sw)
+a number of times. Each run is a separate child process so that the
+peak RSS from wait4() belongs to that run alone. Results go out as one JSON
+array with median/p95 wall and compute times, trials/s, edges/s, and peak RSS.
+The family of a graph is the name of the directory it was found in.
+*/
+
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <dirent.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/wait.h>
+#include <boost/graph/adjacency_list.hpp>
+#include <boost/graph/stoer_wagner_min_cut.hpp>
+#include "ECLgraph.h"
+
+typedef boost::adjacency_list< boost::vecS, boost::vecS, boost::undirectedS,
+    boost::no_property, boost::property< boost::edge_weight_t, long long > >
+    undirected_graph;
+
+struct Graph {
+  std::string path;
+  std::string family;
+  long long nodes;
+  long long edges;
+};
+
+struct Run {
+  double wall;
+  double compute;
+  long rss_kb;
+  long long cut;
+};
+
+static double now()
+{
+  struct timeval t;
+  gettimeofday(&t, NULL);
+  return t.tv_sec + t.tv_usec / 1000000.0;
+}
+
+// value printed after 'key' in the output of a child, or -1 if it is missing
+static double field(const std::string& out, const char* const key)
+{
+  const std::size_t pos = out.find(key);
+  if (pos == std::string::npos) return -1.0;
+  return atof(out.c_str() + pos + strlen(key));
+}
+
+// run argv[0] with its output captured and OMP_NUM_THREADS set; exits the benchmark if the child fails
+static Run spawn(const std::vector<std::string>& args, const int threads, std::string& out)
+{
+  int fd[2];
+  if (pipe(fd) != 0) {fprintf(stderr, "ERROR: could not create pipe\n\n");  exit(-1);}
+  const double start = now();
+  const pid_t pid = fork();
+  if (pid < 0) {fprintf(stderr, "ERROR: fork failed\n\n");  exit(-1);}
+  if (pid == 0) {
+    close(fd[0]);
+    dup2(fd[1], STDOUT_FILENO);
+    close(fd[1]);
+    setenv("OMP_NUM_THREADS", std::to_string(threads).c_str(), 1);
+    std::vector<char*> argv;
+    for (const std::string& a : args) argv.push_back((char*)a.c_str());
+    argv.push_back(NULL);
+    execv(argv[0], argv.data());
+    fprintf(stderr, "ERROR: could not run %s\n\n", argv[0]);
+    _exit(127);
+  }
+  close(fd[1]);
+  out.clear();
+  char buf[4096];
+  ssize_t cnt;
+  while ((cnt = read(fd[0], buf, sizeof(buf))) > 0) out.append(buf, cnt);
+  close(fd[0]);
+
+  int status;
+  struct rusage ru;
+  if (wait4(pid, &status, 0, &ru) != pid) {fprintf(stderr, "ERROR: wait4 failed\n\n");  exit(-1);}
+  Run r;
+  r.wall = now() - start;
+  r.rss_kb = ru.ru_maxrss;
+  if (!WIFEXITED(status) || (WEXITSTATUS(status) != 0)) {fprintf(stderr, "ERROR: %s failed on %s\n\n", args[0].c_str(), args.back().c_str());  exit(-1);}
+  r.compute = -1.0;
+  r.cut = -1;
+  return r;
+}
+
+// Stoer-Wagner on the Boost adjacency list, in a child process like the other codes
+static Run stoer_wagner(const Graph& gr)
+{
+  std::string out;
+  int fd[2];
+  if (pipe(fd) != 0) {fprintf(stderr, "ERROR: could not create pipe\n\n");  exit(-1);}
+  const double start = now();
+  const pid_t pid = fork();
+  if (pid < 0) {fprintf(stderr, "ERROR: fork failed\n\n");  exit(-1);}
+  if (pid == 0) {
+    close(fd[0]);
+    ECLgraph64 g = readECLgraphT<int, long long>(gr.path.c_str());
+    const double beg = now();
+    undirected_graph h(g.nodes);
+    for (int v = 0; v < g.nodes; v++) {
+      for (long long i = g.nindex[v]; i < g.nindex[v + 1]; i++) {
+        if (v < g.nlist[i]) add_edge(v, g.nlist[i], (g.eweight != NULL) ? g.eweight[i] : 1, h);
+      }
+    }
+    const long long cut = boost::stoer_wagner_min_cut(h, get(boost::edge_weight, h));
+    const double runtime = now() - beg;
+    const std::string res = "compute time: " + std::to_string(runtime) + "\nminimum cut found: " + std::to_string(cut) + "\n";
+    if (write(fd[1], res.c_str(), res.size()) != (ssize_t)res.size()) _exit(1);
+    close(fd[1]);
+    _exit(0);
+  }
+  close(fd[1]);
+  char buf[4096];
+  ssize_t cnt;
+  while ((cnt = read(fd[0], buf, sizeof(buf))) > 0) out.append(buf, cnt);
+  close(fd[0]);
+
+  int status;
+  struct rusage ru;
+  if (wait4(pid, &status, 0, &ru) != pid) {fprintf(stderr, "ERROR: wait4 failed\n\n");  exit(-1);}
+  if (!WIFEXITED(status) || (WEXITSTATUS(status) != 0)) {fprintf(stderr, "ERROR: Stoer-Wagner failed on %s\n\n", gr.path.c_str());  exit(-1);}
+  Run r;
+  r.wall = now() - start;
+  r.rss_kb = ru.ru_maxrss;
+  r.compute = field(out, "compute time: ");
+  r.cut = (long long)field(out, "minimum cut found: ");
+  return r;
+}
+
+// nearest-rank percentile
+static double percentile(std::vector<double> val, const double p)
+{
+  std::sort(val.begin(), val.end());
+  const std::size_t k = (std::size_t)std::ceil(p * val.size());
+  return val[std::max(k, (std::size_t)1) - 1];
+}
+
+static void collect(const std::string& path, std::vector<Graph>& graphs)
+{
+  struct stat st;
+  if (stat(path.c_str(), &st) != 0) {fprintf(stderr, "ERROR: could not open file %s\n\n", path.c_str());  exit(-1);}
+  if (S_ISDIR(st.st_mode)) {
+    DIR* const dir = opendir(path.c_str());
+    if (dir == NULL) {fprintf(stderr, "ERROR: could not open directory %s\n\n", path.c_str());  exit(-1);}
+    std::vector<std::string> names;
+    struct dirent* ent;
+    while ((ent = readdir(dir)) != NULL) {
+      if (ent->d_name[0] != '.') names.push_back(ent->d_name);
+    }
+    closedir(dir);
+    std::sort(names.begin(), names.end());
+    for (const std::string& n : names) collect(path + "/" + n, graphs);
+  } else {
+    const ECLheader h = readECLheader(path.c_str());
+    std::string dir = path.substr(0, path.find_last_of('/') + 1);
+    while (!dir.empty() && (dir.back() == '/')) dir.pop_back();
+    const std::string family = dir.empty() ? "." : dir.substr(dir.find_last_of('/') + 1);
+    graphs.push_back(Graph{path, family, h.nodes, h.edges});
+  }
+}
+
+int main(int argc, char* argv [])
+{
+  fprintf(stderr, "Min-cut benchmark (%s)\n\n", __FILE__);
+
+  std::string bindir;
+  {
+    const std::string self = argv[0];
+    const std::size_t slash = self.find_last_of('/');
+    bindir = (slash == std::string::npos) ? "." : self.substr(0, slash);
+  }
+  std::vector<int> threads = {1};
+  int reps = 5;
+  int perms = 100;
+  long long sw_nodes = 10000;
+  const char* engine = "kruskal";
+  const char* outname = NULL;
+  int opt;
+  while ((opt = getopt(argc, argv, "b:t:r:p:n:e:o:")) != -1) {
+    switch (opt) {
+      case 'b':
+        bindir = optarg;
+        break;
+      case 't': {
+        threads.clear();
+        char* tok = strtok(optarg, ",");
+        while (tok != NULL) {
+          threads.push_back(atoi(tok));
+          tok = strtok(NULL, ",");
+        }
+        break;
+      }
+      case 'r':
+        reps = atoi(optarg);
+        break;
+      case 'p':
+        perms = atoi(optarg);
+        break;
+      case 'n':
+        sw_nodes = atoll(optarg);
+        break;
+      case 'e':
+        engine = optarg;
+        break;
+      case 'o':
+        outname = optarg;
+        break;
+      default:
+        optind = argc + 1;
+    }
+  }
+  if ((optind >= argc) || threads.empty() || (reps < 1) || (perms < 1) || (*std::min_element(threads.begin(), threads.end()) < 1)) {
+    fprintf(stderr, "USAGE: %s [-b bin_dir] [-t threads,...] [-r repetitions] [-p permutations] [-n max_stoer_wagner_nodes] [-e engine] [-o out.json] graph_file_or_dir ...\n\n", argv[0]);  exit(-1);
+  }
+
+  std::vector<Graph> graphs;
+  for (int a = optind; a < argc; a++) collect(argv[a], graphs);
+
+  FILE* const f = (outname != NULL) ? fopen(outname, "w") : stdout;
+  if (f == NULL) {fprintf(stderr, "ERROR: could not open file %s\n\n", outname);  exit(-1);}
+  fprintf(f, "[");
+  bool first = true;
+  const char* const algorithms[] = {"karger", "ecl-cc", "stoer-wagner", "stoer-wagner-csr"};
+  for (const Graph& gr : graphs) {
+    for (const char* const alg : algorithms) {
+      const bool sw = (strcmp(alg, "stoer-wagner") == 0);
+      const bool serial = (strncmp(alg, "stoer-wagner", 12) == 0);
+      if (serial && (gr.nodes > sw_nodes)) continue;
+      for (const int t : (serial ? std::vector<int>{1} : threads)) {
+        fprintf(stderr, "%s: %s with %d thread(s)\n", gr.path.c_str(), alg, t);
+        std::vector<double> wall, compute;
+        long rss_kb = 0;
+        long long cut = -1;
+        int trials = 1;
+        for (int r = 0; r < reps; r++) {
+          Run run;
+          std::string out;
+          if (sw) {
+            run = stoer_wagner(gr);
+          } else if (strcmp(alg, "karger") == 0) {
+            trials = perms;
+            run = spawn({bindir + "/Karger", "-e", engine, gr.path, std::to_string(perms)}, t, out);
+            run.compute = field(out, "trial time: ");
+            run.cut = (long long)field(out, "minimum cut found: ");
+          } else if (serial) {
+            run = spawn({bindir + "/Karger", "-e", "sw", gr.path, "1"}, t, out);
+            run.compute = field(out, "trial time: ");
+            run.cut = (long long)field(out, "minimum cut found: ");
+          } else {
+            run = spawn({bindir + "/Karger-orig", gr.path}, t, out);
+            run.compute = field(out, "compute time: ");
+          }
+          wall.push_back(run.wall);
+          compute.push_back(run.compute);
+          rss_kb = std::max(rss_kb, run.rss_kb);
+          cut = run.cut;
+        }
+        // codes that time their work too coarsely to measure a run fall back to the wall time
+        const double cmed = percentile(compute, 0.5);
+        const double secs = (cmed > 0.0) ? cmed : percentile(wall, 0.5);
+        fprintf(f, "%s\n  {\"graph\": \"%s\", \"family\": \"%s\", \"nodes\": %lld, \"edges\": %lld, \"algorithm\": \"%s\", \"threads\": %d, \"repetitions\": %d, \"trials\": %d, ",
+                first ? "" : ",", gr.path.c_str(), gr.family.c_str(), gr.nodes, gr.edges, alg, t, reps, trials);
+        fprintf(f, "\"wall_median_s\": %.6f, \"wall_p95_s\": %.6f, \"compute_median_s\": %.6f, \"compute_p95_s\": %.6f, \"trials_per_s\": %.3f, \"edges_per_s\": %.1f, \"peak_rss_kb\": %ld, \"cut\": %lld}",
+                percentile(wall, 0.5), percentile(wall, 0.95), cmed, percentile(compute, 0.95), trials / secs, (double)gr.edges * trials / secs, rss_kb, cut);
+        first = false;
+        fflush(f);
+      }
+    }
+  }
+  fprintf(f, "\n]\n");
+  if (f != stdout) fclose(f);
+  return 0;
+}
+
+
+/*
+./Bench -t 1,2,4,8 -r 5 -p 100 -o results.json graphs/
+*/
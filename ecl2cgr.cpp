@@ -0,0 +1,39 @@
+#include <cstdlib>
+#include <cstdio>
+#include "ECLgraph.h"
+#include "ECLcgraph.h"
+
+
+int main(int argc, char* argv [])
+{
+  printf("Convert ECL graph to compressed ECL graph (%s)\n\n", __FILE__);
+
+  // process command line
+  if (argc != 3) {fprintf(stderr, "USAGE: %s input_graph output_graph\n", argv[0]); exit(-1);}
+
+  // read graph
+  ECLgraph64 g = readECLgraphT<int, long long>(argv[1]);
+  printf("input: %s\n", argv[1]);
+  printf("nodes: %d\n", g.nodes);
+  printf("edges: %lld (%lld)\n", g.edges / 2, g.edges);
+
+  // compress and write
+  ECLcgraphT<int, long long> c = compressECLgraph(g);
+  writeECLcgraph(c, argv[2]);
+
+  const double before = (g.nodes + 1.0) * sizeof(g.nindex[0]) + g.edges * (sizeof(g.nlist[0]) + ((g.eweight != NULL) ? sizeof(g.eweight[0]) : 0));
+  const double after = (c.nodes + 1.0) * sizeof(c.boff[0]) + c.boff[c.nodes];
+  printf("output: %s\n", argv[2]);
+  printf("bytes per edge: %.2f (was %.2f)\n", after / std::max(g.edges, 1LL), before / std::max(g.edges, 1LL));
+  printf("compression ratio: %.2f\n\n", before / after);
+
+  // clean up
+  freeECLcgraph(c);
+  freeECLgraph(g);
+  return 0;
+}
+
+
+/*
+./ecl2cgr graph.egr graph.cgr
+*/
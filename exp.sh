@@ -1,19 +1,26 @@
 #!/usr/bin/env bash
 
-current_directory=$(pwd)
-graphs_dir=./Indigo3Suite/graphGen/generatedGraphs/apg
+# usage: [BUILD_DIR=dir] [THREADS=1,2,4] ./exp.sh [graphs_dir ...]
+build_dir=${BUILD_DIR:-./build}
+threads=${THREADS:-1,2,4,8}
+graphs_dirs=("$@")
+if [ ${#graphs_dirs[@]} -eq 0 ]; then
+  graphs_dirs=(./Indigo3Suite/graphGen/generatedGraphs/apg)
+fi
+
+for graphs_dir in "${graphs_dirs[@]}"; do
+  if [ ! -e "$graphs_dir" ]; then
+    echo "Error: directory $graphs_dir not found"
+    exit 1
+  fi
+done
 
-if [ ! -d "$graphs_dir" ]; then
-  echo "Error: directory $graphs_dir not found"
+if [ ! -x "$build_dir/Bench" ]; then
+  echo "Error: $build_dir/Bench not found (set BUILD_DIR)"
   exit 1
 fi
 
-filename_timestamp=$(date +'%m-%d-%Y_%H-%M-%S').out
+filename_timestamp=$(date +'%m-%d-%Y_%H-%M-%S').json
 echo "Timestamp for filename: $filename_timestamp"
 
-for file_path in "$graphs_dir"/*; do
-  if [ -f "$file_path" ]; then
-    echo "Processing file: $file_path"
-    ./cmake-build-debug-wsl/Karger "$file_path" >> "$filename_timestamp" 2>&1
-  fi
-done
\ No newline at end of file
+"$build_dir/Bench" -b "$build_dir" -t "$threads" -o "$filename_timestamp" "${graphs_dirs[@]}"